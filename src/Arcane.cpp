@@ -14,6 +14,8 @@ You should have received a copy of the GNU General Public License along with thi
 #include "network.hpp"
 #include "quantizer.hpp"
 #include "lcd.hpp"
+#include "profiler.hpp"
+#include "scheduler.hpp"
 #include <ctime>
 #include <thread>
 
@@ -50,7 +52,7 @@ struct ArcaneBase : Module {
     
     // LCD stuff
     Lcd::LcdStatus lcdStatus;
-    dsp::ClockDivider lcdDivider; 
+    Scheduler::Divider lcdDivider; 
     int lcdMode = 0;
     std::string todaysFortuneDate = getCurrentFortuneDate(); // Used to display on the LCD. Once set it changes only on reset.
     
@@ -58,12 +60,12 @@ struct ArcaneBase : Module {
     int arcana, bpm, wish;
     std::array<int, 8> notePattern;
     std::array<bool, 16> patternB, patternC, patternD, patternE; // There is no pattern A
-    std::array<bool, 12> scale;
+    Quantizer::ScaleMask scale;
         
-    dsp::ClockDivider readJsonDivider;
+    Scheduler::Divider readJsonDivider;
     // Huge performance gain not to send all static values each tick. Will do that unless people yell it breaks something.
-    dsp::ClockDivider refreshDivider;	
-    dsp::ClockDivider expanderDivider;
+    Scheduler::Divider refreshDivider;	
+    Scheduler::Divider expanderDivider;
 
     bool readTodaysFortune() {		
         std::string filename = asset::user("AriaSalvatrice/Arcane/").c_str() + todaysFortuneDate + ".json";
@@ -111,7 +113,7 @@ struct ArcaneBase : Module {
         json_t* scaleNumJ = json_object_get(rootJ, "scale");
         if (scaleNumJ) scaleNum = json_integer_value(scaleNumJ);
         for (int i = 0; i < 12; ++i){
-            scale[11 - i] = (scaleNum >> i) & 1;
+            scale.set(11 - i, (scaleNum >> i) & 1);
             lcdStatus.pianoDisplay[11 - i] = (scaleNum >> i) & 1;
         }
         
@@ -246,6 +248,10 @@ struct Arcane : ArcaneBase {
     dsp::SchmittTrigger resetCvTrigger;
     dsp::SchmittTrigger resetButtonTrigger;
     
+    Quantizer::Engine quantizer;
+    enum ProfileIds { PROFILE_PROCESS, PROFILE_SEND_PATTERNS, NUM_PROFILES };
+    Profiler::Profile profile {"process", "sendPatterns"};
+
     // Only for Arcane
     bool cardDirty = true;
     int cardDelayCounter = 0;
@@ -254,9 +260,7 @@ struct Arcane : ArcaneBase {
         outputs[ARCANA_OUTPUT].setVoltage( arcana * 0.1f );
         outputs[BPM_NUM_OUTPUT].setVoltage (log2f(1.0f / (120.f / bpm)));
         
-        int notesInScale = 0;
-        for (int i = 0; i < 12; i++)
-            if (scale[i]) notesInScale++;
+        int notesInScale = scale.count();
         for (int i = 0; i < 8; i++) {
             outputs[SCALE_OUTPUT].setVoltage( (notePattern[i] / 12.f), i);
             float paddedOutput = i < notesInScale ? (notePattern[i] / 12.f) : (notePattern[i] / 12.f + 1.f);
@@ -362,6 +366,7 @@ struct Arcane : ArcaneBase {
     // Yeah I know, copy-paste cowgirl coding in here. But it works, punk. 
     // This is where the bulk of the CPU time goes. Can I improve it? I don't see how, seems unsafe to skip steps on a clock.
     void sendPatterns(const ProcessArgs& args) {
+        PROFILE_SCOPE(profile, PROFILE_SEND_PATTERNS);
         outputs[PATTERN_B_32_OUTPUT].setVoltage( (pulseThirtySecond and patternB[thirtySecondCounter]) ? 10.f : 0.f );
         outputs[PATTERN_C_32_OUTPUT].setVoltage( (pulseThirtySecond and patternC[thirtySecondCounter]) ? 10.f : 0.f );
         outputs[PATTERN_D_32_OUTPUT].setVoltage( (pulseThirtySecond and patternD[thirtySecondCounter]) ? 10.f : 0.f );
@@ -519,6 +524,7 @@ struct Arcane : ArcaneBase {
         lcdStatus.lcdDirty = true;
         cardDirty = true;
         ArcaneBase::onReset();
+        quantizer.setScale(scale);
     }
     
     // Since there's no guarantee the patterns will be the same when the user
@@ -546,7 +552,11 @@ struct Arcane : ArcaneBase {
     }
     
     void process(const ProcessArgs& args) override {
-        if (!jsonParsed and readJsonDivider.process()) jsonParsed = readTodaysFortune();
+        PROFILE_SCOPE(profile, PROFILE_PROCESS);
+        if (!jsonParsed and readJsonDivider.process()) {
+            jsonParsed = readTodaysFortune();
+            quantizer.setScale(scale);
+        }
         if (jsonParsed) {
             if (refreshDivider.process()) sendStaticVoltage(args);
             
@@ -557,9 +567,9 @@ struct Arcane : ArcaneBase {
             
             sendPatterns(args);
             
-            // Quantize
-            for (int i = 0; i < inputs[QNT_INPUT].getChannels(); i++)
-                outputs[QNT_OUTPUT].setVoltage(Quantizer::quantize(inputs[QNT_INPUT].getVoltage(i), scale), i);
+            // Quantize, four channels at a time
+            for (int c = 0; c < inputs[QNT_INPUT].getChannels(); c += 4)
+                outputs[QNT_OUTPUT].setVoltageSimd(quantizer.quantize(inputs[QNT_INPUT].getVoltageSimd<simd::float_4>(c)), c);
             outputs[QNT_OUTPUT].setChannels(inputs[QNT_INPUT].getChannels());
         } else { // JSON not parsed, pass quantizer input as-is.
             for (int i = 0; i < inputs[QNT_INPUT].getChannels(); i++)
@@ -872,6 +882,12 @@ struct ArcaneWidget : ModuleWidget {
         // Expander light (3.5mm from edge)
         addChild(createLight<SmallLight<OutputLight>>(mm2px(Vec(x + 38.1, 125.2)), module, Arcane::EXPANDER_LIGHT));
     }
+
+    void appendContextMenu(ui::Menu *menu) override {
+        Arcane *module = dynamic_cast<Arcane*>(this->module);
+        assert(module);
+        Profiler::appendContextMenu(menu, module, module->profile);
+    }
 }; // ArcaneWidget
 
 
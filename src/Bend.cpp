@@ -7,6 +7,7 @@ You should have received a copy of the GNU General Public License along with thi
 // This is an early experiment kept for future reference, will redo entirely from scratch.
 
 #include "plugin.hpp"
+#include "scheduler.hpp"
 // Required on OSX
 #include <array> 
 
@@ -49,7 +50,7 @@ struct Bendlet : Module {
 
 
 struct AriaPbSlider : SvgSlider {
-    dsp::ClockDivider springDivider;
+    Scheduler::Divider springDivider;
     
     AriaPbSlider() {
         setBackgroundSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/pb-bg.svg")));
@@ -14,6 +14,9 @@ You should have received a copy of the GNU General Public License along with thi
 #include "quantizer.hpp"
 #include "lcd.hpp"
 #include "portablesequence.hpp"
+#include "profiler.hpp"
+#include "scheduler.hpp"
+#include "routes.hpp"
 
 namespace Darius {
 
@@ -26,6 +29,7 @@ const int STEP6START = 15; //     20  19  18  17  16  15
 const int STEP7START = 21; //   27  26  25  24  23  22  21  
 const int STEP8START = 28; // 35  34  33  32  31  30  29  28
 const int STEP9START = 36; // (Panel is rotated 90 degrees counter-clockwise compared to this diagram)
+                           // Bigger trees keep going the same way, see routes.hpp
 
 const int DISPLAYDIVIDER = 512;
 const int KNOBDIVIDER = 512;
@@ -39,13 +43,19 @@ enum LcdModes {
     CV_MODE,
     MINMAX_MODE,
     ROUTE_MODE,
-    SLIDE_MODE
+    SLIDE_MODE,
+    PREVIEW_MODE
 };
 
+// Templated over the amount of steps, like Solomon is over its nodes. Only the 8-step one has a panel.
+template <int STEPS>
 struct Darius : Module {
+    typedef Routes::Triangle<STEPS> Triangle;
+    static const int NODES = Triangle::NODES;
+
     enum ParamIds {
-        ENUMS(CV_PARAM, 36),
-        ENUMS(ROUTE_PARAM, 36),
+        ENUMS(CV_PARAM, NODES),
+        ENUMS(ROUTE_PARAM, NODES),
         STEP_PARAM,
         RUN_PARAM,
         RESET_PARAM,
@@ -75,14 +85,14 @@ struct Darius : Module {
         NUM_INPUTS
     };
     enum OutputIds {
-        ENUMS(GATE_OUTPUT, 36),
+        ENUMS(GATE_OUTPUT, NODES),
         CV_OUTPUT, // 1.2.0 release
         GLOBAL_GATE_OUTPUT, // 1.5.0 release
         NUM_OUTPUTS
     };
     enum LightIds {
-        ENUMS(CV_LIGHT, 36),
-        ENUMS(GATE_LIGHT, 36), // 1.2.0 release
+        ENUMS(CV_LIGHT, NODES),
+        ENUMS(GATE_LIGHT, NODES), // 1.2.0 release
         SEED_LIGHT,
         NUM_LIGHTS
     };
@@ -101,23 +111,32 @@ struct Darius : Module {
     bool routesToBinaryTree = false;
     bool copyPortableSequence = false;
     bool pastePortableSequence = false;
-    std::array<bool, 12> scale;
+    bool previewNextRoute = false;
+    bool legacySeeds = false; // Patches from before the prng got faster, so a seed still leads to the same routes
+    Quantizer::ScaleMask scale;
     int stepFirst = 1;
-    int stepLast = 8;
+    int stepLast = STEPS;
     int step = 0;
     int node = 0;
     int lastNode = 0;
     int lastGate = 0;
-    int pathTraveled[8] = { 0, -1, -1, -1, -1, -1, -1, -1 }; // -1 = not gone there yet
+    int pathTraveled[STEPS]; // -1 = not gone there yet
+    int upcomingPath[STEPS];
     int lcdMode = INIT_MODE;
     int lastCvChanged = 0;
     int lastRouteChanged = 0;
     float randomSeed = 0.f;
+    float upcomingSeed = 0.f; // Picked in advance when there's no seed input, so the next route can be known
     float slideDuration = 0.f; // In ms
     float slideCounter = 0.f;
     float lastOutput = 0.f;
     float lcdLastInteraction = 0.f;
-    float probabilities[36];
+    float probabilities[NODES];
+    float routes[NODES]; // The route knobs the probabilities were last worked out from
+    float gateBrightness[NODES]; // What the gate lights were last set to
+    int litStepFirst = 0;
+    int litStepLast = 0;
+    bool gateLightsDirty = true;
     float resetDelay = -1.f; // 0 when reset started
     dsp::SchmittTrigger stepUpCvTrigger;
     dsp::SchmittTrigger stepDownCvTrigger;
@@ -130,18 +149,22 @@ struct Darius : Module {
     dsp::SchmittTrigger randomizeCvTrigger;
     dsp::SchmittTrigger randomizeRouteTrigger;
     dsp::PulseGenerator manualStepTrigger;
-    dsp::ClockDivider knobDivider;
-    dsp::ClockDivider displayDivider;
-    prng::prng prng;
+    Scheduler::Divider knobDivider;
+    Scheduler::Divider displayDivider;
+    Routes::Lookahead<STEPS, prng::prng> lookahead; // The draws of the current route
+    Routes::Lookahead<STEPS, prng::prng> upcoming; // And of the next one, worked out at display rate
+    Quantizer::Engine quantizer;
     Lcd::LcdStatus lcdStatus;
+    enum ProfileIds { PROFILE_PROCESS, PROFILE_UPDATE_ROUTES, PROFILE_UPDATE_LCD, NUM_PROFILES };
+    Profiler::Profile profile {"process", "updateRoutes", "updateLcd"};
 
     Darius() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         configParam(STEP_PARAM, 0.f, 1.f, 0.f, "Step");
         configParam(RUN_PARAM, 0.f, 1.f, 1.f, "Run");
         configParam(RESET_PARAM, 0.f, 1.f, 0.f, "Reset");
-        configParam(STEPFIRST_PARAM, 1.f, 8.f, 1.f, "First step");
-        configParam(STEPCOUNT_PARAM, 1.f, 8.f, 8.f, "Last step");
+        configParam(STEPFIRST_PARAM, 1.f, (float) STEPS, 1.f, "First step");
+        configParam(STEPCOUNT_PARAM, 1.f, (float) STEPS, (float) STEPS, "Last step");
         configParam(RANDCV_PARAM, 0.f, 1.f, 0.f, "Randomize CV knobs");
         configParam(RANDROUTE_PARAM, 0.f, 1.f, 0.f, "Meta-randomize random route knobs");
         configParam(SEED_MODE_PARAM, 0.f, 1.f, 0.f, "New random seed on first or all nodes");
@@ -152,16 +175,22 @@ struct Darius : Module {
         configParam(KEY_PARAM, 0.f, 11.f, 0.f, "Key");
         configParam(SCALE_PARAM, 0.f, (float) Quantizer::NUM_SCALES - 1, 2.f, "Scale");
         configParam(SLIDE_PARAM, 0.f, 10.f, 0.f, "Slide");
-        for (int i = 0; i < STEP9START; i++)
+        for (int i = 0; i < NODES; i++)
             configParam(CV_PARAM + i, 0.f, 10.f, 5.f, "CV");
-        for (int i = 0; i < STEP8START; i++)
+        for (int i = 0; i < Triangle::stepStart(STEPS - 1); i++)
             configParam(ROUTE_PARAM + i, 0.f, 1.f, 0.5f, "Random route");
         knobDivider.setDivision(KNOBDIVIDER);
         displayDivider.setDivision(DISPLAYDIVIDER);
         lcdStatus.lcdLayout = Lcd::TEXT1_AND_TEXT2_LAYOUT;
         lcdStatus.lcdText1 = "MEDITATE..."; // Loading message
         lcdStatus.lcdText2 = "MEDITATION."; // https://www.youtube.com/watch?v=JqLNY1zyQ6o
+        pathTraveled[0] = 0;
+        for (int i = 1; i < STEPS; i++) pathTraveled[i] = -1;
+        for (int i = 0; i < NODES; i++) routes[i] = NAN;
+        for (int i = 0; i < NODES; i++) gateBrightness[i] = NAN;
+        probabilities[0] = 1.f;
         for (int i = 0; i < 100; i++) random::uniform(); // The first few seeds we get seem bad, need more warming up. Might just be superstition.
+        upcomingSeed = random::uniform();
     }
     
     json_t* dataToJson() override {
@@ -171,10 +200,12 @@ struct Darius : Module {
         json_object_set_new(rootJ, "lastNode", json_integer(lastNode));
         json_object_set_new(rootJ, "lastGate", json_integer(lastGate));
         json_t *pathTraveledJ = json_array();
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < STEPS; i++) {
             json_array_insert_new(pathTraveledJ, i, json_integer(pathTraveled[i]));
         } 
         json_object_set_new(rootJ, "pathTraveled", pathTraveledJ);
+        json_object_set_new(rootJ, "previewNextRoute", json_boolean(previewNextRoute));
+        json_object_set_new(rootJ, "legacySeeds", json_boolean(legacySeeds));
         return rootJ;
     }
     
@@ -197,13 +228,20 @@ struct Darius : Module {
         }
         json_t *pathTraveledJ = json_object_get(rootJ, "pathTraveled");
         if (pathTraveledJ) {
-            for (int i = 0; i < 8; i++) {
+            for (int i = 0; i < STEPS; i++) {
                 json_t *pathTraveledNodeJ = json_array_get(pathTraveledJ, i);
                 if (pathTraveledNodeJ) {
                     pathTraveled[i] = json_integer_value(pathTraveledNodeJ);
                 }
             }
         }
+        json_t* previewNextRouteJ = json_object_get(rootJ, "previewNextRoute");
+        if (previewNextRouteJ){
+            previewNextRoute = json_boolean_value(previewNextRouteJ);
+        }
+        // Saved before it existed, so it has to keep the old seeds
+        json_t* legacySeedsJ = json_object_get(rootJ, "legacySeeds");
+        setLegacySeeds(legacySeedsJ ? json_boolean_value(legacySeedsJ) : true);
         lightsReset = true;
     }
 
@@ -212,11 +250,11 @@ struct Darius : Module {
     // Thanks to David O'Rourke for the example implementation!
     // https://github.com/AriaSalvatrice/AriaVCVModules/issues/14
     struct BulkCvAction : history::ModuleAction {
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
         int param;
 
-        BulkCvAction(int moduleId, std::string name, int param, std::array<float, 36> oldValues, std::array<float, 36> newValues) {
+        BulkCvAction(int moduleId, std::string name, int param, std::array<float, NODES> oldValues, std::array<float, NODES> newValues) {
             this->moduleId = moduleId;
             this->name = name;
             this->param = param;
@@ -227,89 +265,85 @@ struct Darius : Module {
         void undo() override {
             Darius *module = dynamic_cast<Darius*>(APP->engine->getModule(this->moduleId));
             if (module) {
-                for (int i = 0; i < 36; i++) module->params[param + i].setValue(this->oldValues[i]);
+                for (int i = 0; i < NODES; i++) module->params[param + i].setValue(this->oldValues[i]);
             }
         }
 
         void redo() override {
             Darius *module = dynamic_cast<Darius*>(APP->engine->getModule(this->moduleId));
             if (module) {
-                for (int i = 0; i < 36; i++) module->params[param + i].setValue(this->newValues[i]);
+                for (int i = 0; i < NODES; i++) module->params[param + i].setValue(this->newValues[i]);
             }
         }
     };
 
     void randomizeCv(const ProcessArgs& args){
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[CV_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[CV_PARAM + i].setValue(random::uniform() * 10.f);
-        for (int i = 0; i < 36; i++) newValues[i] = params[CV_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[CV_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[CV_PARAM + i].setValue(random::uniform() * 10.f);
+        for (int i = 0; i < NODES; i++) newValues[i] = params[CV_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "randomize Darius CV", CV_PARAM, oldValues, newValues));
     }
     
     void randomizeRoute(const ProcessArgs& args){
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[ROUTE_PARAM + i].setValue(random::uniform());	
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[ROUTE_PARAM + i].setValue(random::uniform());	
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "randomize Darius Routes", ROUTE_PARAM, oldValues, newValues));
     }
     
     void processResetCV(const ProcessArgs& args){
         resetCV = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[CV_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[CV_PARAM + i].setValue(5.f);	
-        for (int i = 0; i < 36; i++) newValues[i] = params[CV_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[CV_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[CV_PARAM + i].setValue(5.f);	
+        for (int i = 0; i < NODES; i++) newValues[i] = params[CV_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "reset Darius CV", CV_PARAM, oldValues, newValues));
     }
 
     void processResetRoutes(const ProcessArgs& args){
         resetRoutes = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[ROUTE_PARAM + i].setValue(0.5f);	
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[ROUTE_PARAM + i].setValue(0.5f);	
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "reset Darius Routes", ROUTE_PARAM, oldValues, newValues));
     }
 
     void processRoutesToTop(const ProcessArgs& args){
         routesToTop = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[ROUTE_PARAM + i].setValue(0.f);	
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[ROUTE_PARAM + i].setValue(0.f);	
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "set Darius Routes to Top", ROUTE_PARAM, oldValues, newValues));
     }
 
     void processRoutesToBottom(const ProcessArgs& args){
         routesToBottom = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[ROUTE_PARAM + i].setValue(1.f);	
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) params[ROUTE_PARAM + i].setValue(1.f);	
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "set Darius Routes to Bottom", ROUTE_PARAM, oldValues, newValues));
     }
 
     void processRoutesToEqualProbability(const ProcessArgs& args){
         routesToEqualProbability = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        params[ROUTE_PARAM].setValue(0.5f);
-        for (int i = 0; i < 2; i++) params[ROUTE_PARAM + i + STEP2START].setValue( (i + 1) / 3.f );
-        for (int i = 0; i < 3; i++) params[ROUTE_PARAM + i + STEP3START].setValue( (i + 1) / 4.f );
-        for (int i = 0; i < 4; i++) params[ROUTE_PARAM + i + STEP4START].setValue( (i + 1) / 5.f );
-        for (int i = 0; i < 5; i++) params[ROUTE_PARAM + i + STEP5START].setValue( (i + 1) / 6.f );
-        for (int i = 0; i < 6; i++) params[ROUTE_PARAM + i + STEP6START].setValue( (i + 1) / 7.f );
-        for (int i = 0; i < 7; i++) params[ROUTE_PARAM + i + STEP7START].setValue( (i + 1) / 8.f );
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        for (int step = 0; step < STEPS - 1; step++) {
+            for (int i = 0; i <= step; i++) params[ROUTE_PARAM + i + Triangle::stepStart(step)].setValue( (i + 1) / (step + 2.f) );
+        }
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "set Darius Routes to Spread out", ROUTE_PARAM, oldValues, newValues));
     }
 
@@ -317,69 +351,47 @@ struct Darius : Module {
     // https://community.vcvrack.com/t/arias-cool-and-nice-thread-of-barely-working-betas-and-bug-squashing-darius-update/8208/13?u=aria_salvatrice
     void processRoutesToBinaryTree(const ProcessArgs& args){
         routesToBinaryTree = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
-        for (int i = 0; i < 36; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
-        for (int i = 0; i < 36; i++) params[ROUTE_PARAM + i].setValue(0.5f);
-        params[ROUTE_PARAM +  1].setValue(0.f);
-        params[ROUTE_PARAM +  2].setValue(1.f);
-        params[ROUTE_PARAM +  6].setValue(0.f);
-        params[ROUTE_PARAM +  7].setValue(0.f);
-        params[ROUTE_PARAM +  8].setValue(1.f);
-        params[ROUTE_PARAM +  9].setValue(1.f);
-        params[ROUTE_PARAM + 10].setValue(0.f);
-        params[ROUTE_PARAM + 11].setValue(1.f);
-        params[ROUTE_PARAM + 13].setValue(0.f);
-        params[ROUTE_PARAM + 14].setValue(1.f);
-        params[ROUTE_PARAM + 15].setValue(0.f);
-        params[ROUTE_PARAM + 17].setValue(0.f);
-        params[ROUTE_PARAM + 18].setValue(1.f);
-        params[ROUTE_PARAM + 20].setValue(1.f);
-        for (int i = 0; i < 36; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[ROUTE_PARAM + i].getValue();
+        float routes[NODES];
+        Triangle::binaryTree(routes);
+        for (int i = 0; i < NODES; i++) params[ROUTE_PARAM + i].setValue(routes[i]);
+        for (int i = 0; i < NODES; i++) newValues[i] = params[ROUTE_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "set Darius Routes to Binary tree", ROUTE_PARAM, oldValues, newValues));
     }
 
     void importPortableSequence(const ProcessArgs& args){
         pastePortableSequence = false;
-        std::array<float, 36> oldValues;
-        std::array<float, 36> newValues;
+        std::array<float, NODES> oldValues;
+        std::array<float, NODES> newValues;
         PortableSequence::Sequence sequence;
         sequence.fromClipboard();
         sequence.sort();
         sequence.clampValues();
-        for (int i = 0; i < 36; i++) oldValues[i] = params[CV_PARAM + i].getValue(); 
-        for(int i = 0; i < 1; i++) params[CV_PARAM + i + STEP1START].setValue( (sequence.notes.size() > 0) ? clamp(sequence.notes[0].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 2; i++) params[CV_PARAM + i + STEP2START].setValue( (sequence.notes.size() > 1) ? clamp(sequence.notes[1].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 3; i++) params[CV_PARAM + i + STEP3START].setValue( (sequence.notes.size() > 2) ? clamp(sequence.notes[2].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 4; i++) params[CV_PARAM + i + STEP4START].setValue( (sequence.notes.size() > 3) ? clamp(sequence.notes[3].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 5; i++) params[CV_PARAM + i + STEP5START].setValue( (sequence.notes.size() > 4) ? clamp(sequence.notes[4].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 6; i++) params[CV_PARAM + i + STEP6START].setValue( (sequence.notes.size() > 5) ? clamp(sequence.notes[5].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 7; i++) params[CV_PARAM + i + STEP7START].setValue( (sequence.notes.size() > 6) ? clamp(sequence.notes[6].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for(int i = 0; i < 8; i++) params[CV_PARAM + i + STEP8START].setValue( (sequence.notes.size() > 7) ? clamp(sequence.notes[7].pitch + 4.f, 0.f, 10.f) : 5.f);
-        for (int i = 0; i < 36; i++) newValues[i] = params[CV_PARAM + i].getValue();
+        for (int i = 0; i < NODES; i++) oldValues[i] = params[CV_PARAM + i].getValue(); 
+        for (int step = 0; step < STEPS; step++) {
+            for (int i = 0; i <= step; i++) {
+                params[CV_PARAM + i + Triangle::stepStart(step)].setValue( ((int) sequence.notes.size() > step) ? clamp(sequence.notes[step].pitch + 4.f, 0.f, 10.f) : 5.f);
+            }
+        }
+        for (int i = 0; i < NODES; i++) newValues[i] = params[CV_PARAM + i].getValue();
         APP->history->push(new BulkCvAction(this->id, "import Portable Sequence", CV_PARAM, oldValues, newValues));
     }
 
-    // OK, this one is gonna be messy lol
+    // Copies the next route, the same one the display previews
     void exportPortableSequence(const ProcessArgs& args){
         copyPortableSequence = false;
         PortableSequence::Sequence sequence;
         PortableSequence::Note note;
-        prng::prng localPrng;
-        float localSeed;
-        int currentNode = 0;
 
-        if (inputs[SEED_INPUT].isConnected() and (inputs[SEED_INPUT].getVoltage() != 0.f) ) {
-            localSeed = inputs[SEED_INPUT].getVoltage();
-        } else {
-            localSeed = random::uniform();
-        }
-        localPrng.init(localSeed, localSeed);
+        updateRoutes(args);
+        updateUpcomingPath(args);
 
         note.length = 1.f;
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < STEPS; i++) {
             note.start = (float) i;
-            note.pitch = params[CV_PARAM + currentNode].getValue();
+            note.pitch = params[CV_PARAM + upcomingPath[i]].getValue();
             if (params[QUANTIZE_TOGGLE_PARAM].getValue() == 1.f) {
                 note.pitch = rescale(note.pitch, 0.f, 10.f, params[MIN_PARAM].getValue() - 4.f, params[MAX_PARAM].getValue() - 4.f);
                 note.pitch = Quantizer::quantize(note.pitch, scale);
@@ -389,7 +401,6 @@ struct Darius : Module {
             if ( i + 1 >= (int) params[STEPFIRST_PARAM].getValue() && i + 1 <= (int) params[STEPCOUNT_PARAM].getValue()){
                 sequence.addNote(note);
             }
-            currentNode = (localPrng.uniform() < params[ROUTE_PARAM + currentNode].getValue()) ? currentNode + i + 2 : currentNode + i + 1;
         }
 
         sequence.clampValues();
@@ -400,15 +411,45 @@ struct Darius : Module {
 
     void resetPathTraveled(const ProcessArgs& args){
         pathTraveled[0] = 0;
-        for (int i = 1; i < 8; i++) pathTraveled[i] = -1;
+        for (int i = 1; i < STEPS; i++) pathTraveled[i] = -1;
     }
     
     void refreshSeed(const ProcessArgs& args){
         if (inputs[SEED_INPUT].isConnected() and (inputs[SEED_INPUT].getVoltage() != 0.f) ) {
             randomSeed = inputs[SEED_INPUT].getVoltage();
         } else {
-            randomSeed = random::uniform();
+            randomSeed = upcomingSeed;
+            upcomingSeed = random::uniform();
+        }
+    }
+
+    // Starts drawing from the new seed, from the draws already worked out for it if there are any
+    void startRoute(const ProcessArgs& args){
+        if (lookahead.seed != randomSeed && upcoming.seed == randomSeed) std::swap(lookahead, upcoming);
+        lookahead.start(randomSeed);
+    }
+
+    // The cached draws came from the other kind of seeding, so they're thrown away
+    void setLegacySeeds(bool legacy){
+        legacySeeds = legacy;
+        lookahead.prng.legacy = legacy;
+        lookahead.seed = NAN;
+        upcoming.prng.legacy = legacy;
+        upcoming.seed = NAN;
+    }
+
+    bool seedsEveryStep(){
+        return params[SEED_MODE_PARAM].getValue() == 1.0f && inputs[SEED_INPUT].isConnected();
+    }
+
+    // Where the next route would go if the seed and knobs stay as they are
+    void updateUpcomingPath(const ProcessArgs& args){
+        if (inputs[SEED_INPUT].isConnected() and (inputs[SEED_INPUT].getVoltage() != 0.f) ) {
+            upcoming.start(inputs[SEED_INPUT].getVoltage());
+        } else {
+            upcoming.start(upcomingSeed);
         }
+        upcoming.path(routes, upcomingPath, seedsEveryStep());
     }
 
     // Reset to the first step
@@ -419,7 +460,7 @@ struct Darius : Module {
         lastNode = 0;
         lightsReset = true;
         resetPathTraveled(args);
-        for (int i = 0; i < 36; i++)
+        for (int i = 0; i < NODES; i++)
             outputs[GATE_OUTPUT + i].setVoltage(0.f);
         lcdStatus.lcdDirty = true;
         resetDelay = 0.f; // This starts the delay
@@ -498,67 +539,22 @@ struct Darius : Module {
         }
     }
 
-    int getUpChild(int parent){
-        if (parent == 0) return 1;
-        if (parent == 1) return 3;
-        if (parent == 2) return 4;
-        if (parent >= 3 && parent <= 5)   return parent + 3;
-        if (parent >= 6 && parent <= 9)   return parent + 4;
-        if (parent >= 10 && parent <= 14) return parent + 5;
-        if (parent >= 15 && parent <= 20) return parent + 6;
-        if (parent >= 21 && parent <= 27) return parent + 7;
-        return 0;
-    }
-
-    int getDownChild(int parent){
-        return getUpChild(parent) + 1;
-    }
-
+    // Only the display needs the probabilities, and only below the route knobs that moved.
+    // The knobs on the last step don't lead anywhere.
     void updateRoutes(const ProcessArgs& args){
-        // This is hard to think about, so I did it by hand, lol
-        probabilities[0]  = 1.f;
-
-        probabilities[1]  = 1.f - params[ROUTE_PARAM + 0].getValue();
-        probabilities[2]  = params[ROUTE_PARAM + 0].getValue();
-
-        probabilities[3]  = probabilities[1] *  (1.f - params[ROUTE_PARAM + 1].getValue());
-        probabilities[4]  = (probabilities[1] * params[ROUTE_PARAM + 1].getValue()) + (probabilities[2] * (1.f - params[ROUTE_PARAM + 2].getValue()));
-        probabilities[5]  = probabilities[2] * params[ROUTE_PARAM + 2].getValue();
-
-        probabilities[6]  = probabilities[3] *  (1.f - params[ROUTE_PARAM + 3].getValue());
-        probabilities[7]  = (probabilities[3] * params[ROUTE_PARAM + 3].getValue()) + (probabilities[4] * (1.f - params[ROUTE_PARAM + 4].getValue()));
-        probabilities[8]  = (probabilities[4] * params[ROUTE_PARAM + 4].getValue()) + (probabilities[5] * (1.f - params[ROUTE_PARAM + 5].getValue()));
-        probabilities[9]  = probabilities[5] * params[ROUTE_PARAM + 5].getValue();
-
-        probabilities[10] = probabilities[6] *  (1.f - params[ROUTE_PARAM + 6].getValue());
-        probabilities[11] = (probabilities[6] * params[ROUTE_PARAM + 6].getValue()) + (probabilities[7] * (1.f - params[ROUTE_PARAM + 7].getValue()));
-        probabilities[12] = (probabilities[7] * params[ROUTE_PARAM + 7].getValue()) + (probabilities[8] * (1.f - params[ROUTE_PARAM + 8].getValue()));
-        probabilities[13] = (probabilities[8] * params[ROUTE_PARAM + 8].getValue()) + (probabilities[9] * (1.f - params[ROUTE_PARAM + 9].getValue()));
-        probabilities[14] = probabilities[9] * params[ROUTE_PARAM + 9].getValue();
-
-        probabilities[15] = probabilities[10] *  (1.f - params[ROUTE_PARAM + 10].getValue());
-        probabilities[16] = (probabilities[10] * params[ROUTE_PARAM + 10].getValue()) + (probabilities[11] * (1.f - params[ROUTE_PARAM + 11].getValue()));
-        probabilities[17] = (probabilities[11] * params[ROUTE_PARAM + 11].getValue()) + (probabilities[12] * (1.f - params[ROUTE_PARAM + 12].getValue()));
-        probabilities[18] = (probabilities[12] * params[ROUTE_PARAM + 12].getValue()) + (probabilities[13] * (1.f - params[ROUTE_PARAM + 13].getValue()));
-        probabilities[19] = (probabilities[13] * params[ROUTE_PARAM + 13].getValue()) + (probabilities[14] * (1.f - params[ROUTE_PARAM + 14].getValue()));
-        probabilities[20] = probabilities[14] * params[ROUTE_PARAM + 14].getValue();
-
-        probabilities[21] = probabilities[15] *  (1.f - params[ROUTE_PARAM + 15].getValue());
-        probabilities[22] = (probabilities[15] * params[ROUTE_PARAM + 15].getValue()) + (probabilities[16] * (1.f - params[ROUTE_PARAM + 16].getValue()));
-        probabilities[23] = (probabilities[16] * params[ROUTE_PARAM + 16].getValue()) + (probabilities[17] * (1.f - params[ROUTE_PARAM + 17].getValue()));
-        probabilities[24] = (probabilities[17] * params[ROUTE_PARAM + 17].getValue()) + (probabilities[18] * (1.f - params[ROUTE_PARAM + 18].getValue()));
-        probabilities[25] = (probabilities[18] * params[ROUTE_PARAM + 18].getValue()) + (probabilities[19] * (1.f - params[ROUTE_PARAM + 19].getValue()));
-        probabilities[26] = (probabilities[19] * params[ROUTE_PARAM + 19].getValue()) + (probabilities[20] * (1.f - params[ROUTE_PARAM + 20].getValue()));
-        probabilities[27] = probabilities[20] * params[ROUTE_PARAM + 20].getValue();
-
-        probabilities[28] = probabilities[21] *  (1.f - params[ROUTE_PARAM + 21].getValue());
-        probabilities[29] = (probabilities[21] * params[ROUTE_PARAM + 21].getValue()) + (probabilities[22] * (1.f - params[ROUTE_PARAM + 22].getValue()));
-        probabilities[30] = (probabilities[22] * params[ROUTE_PARAM + 22].getValue()) + (probabilities[23] * (1.f - params[ROUTE_PARAM + 23].getValue()));
-        probabilities[31] = (probabilities[23] * params[ROUTE_PARAM + 23].getValue()) + (probabilities[24] * (1.f - params[ROUTE_PARAM + 24].getValue()));
-        probabilities[32] = (probabilities[24] * params[ROUTE_PARAM + 24].getValue()) + (probabilities[25] * (1.f - params[ROUTE_PARAM + 25].getValue()));
-        probabilities[33] = (probabilities[25] * params[ROUTE_PARAM + 25].getValue()) + (probabilities[26] * (1.f - params[ROUTE_PARAM + 26].getValue()));
-        probabilities[34] = (probabilities[26] * params[ROUTE_PARAM + 26].getValue()) + (probabilities[27] * (1.f - params[ROUTE_PARAM + 27].getValue()));
-        probabilities[35] = probabilities[27] * params[ROUTE_PARAM + 27].getValue();
+        PROFILE_SCOPE(profile, PROFILE_UPDATE_ROUTES);
+        typename Triangle::Wedge changed;
+        for (int i = 0; i < Triangle::stepStart(STEPS - 1); i++) {
+            float route = params[ROUTE_PARAM + i].getValue();
+            if (route != routes[i]) {
+                routes[i] = route;
+                changed.add(i);
+            }
+        }
+        if (!changed.empty()) {
+            Triangle::propagate(routes, probabilities, changed);
+            gateLightsDirty = true;
+        }
     }
 
     // From 1ms to 10s. 
@@ -582,11 +578,11 @@ struct Darius : Module {
         // Refresh at the last minute: when about to move the second step (step == 1), not when entering the first (step == 0).
         if (step == 1){
             refreshSeed(args);
-            prng.init(randomSeed, randomSeed);
+            startRoute(args);
         } else {
-            if (params[SEED_MODE_PARAM].getValue() == 1.0f && inputs[SEED_INPUT].isConnected()){
+            if (seedsEveryStep()){
                 refreshSeed(args);
-                prng.init(randomSeed, randomSeed);
+                startRoute(args);
             }
         }
         
@@ -612,12 +608,7 @@ struct Darius : Module {
                     forceDown = false;
                 }
             } else {
-                if (prng.uniform() < params[ROUTE_PARAM + lastNode].getValue()) {
-                    node = node + step + 1;
-                } else {
-                    node = node + step;
-                }
-                
+                node = Triangle::next(node, step, params[ROUTE_PARAM + lastNode].getValue(), lookahead.next());
             }
         }
         pathTraveled[step] = node;
@@ -629,7 +620,7 @@ struct Darius : Module {
         lightsReset = true;
         node = pathTraveled[step];
         // FIXME: This conditional avoids a bizarre problem where randomSeed goes NaN. Not sure what's exactly going on!!
-        if (step < 7) pathTraveled[step + 1] = -1; 
+        if (step < STEPS - 1) pathTraveled[step + 1] = -1; 
         lastNode = node;
         lcdStatus.lcdDirty = true;
     }
@@ -637,11 +628,12 @@ struct Darius : Module {
     void updateScale(const ProcessArgs& args){
         if (inputs[EXT_SCALE_INPUT].isConnected()) {
             for(int i = 0; i < 12; i++) {
-                scale [i] = (inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f) ? true : false;
+                scale.set(i, inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f);
             }
         } else {
             scale = Quantizer::validNotesInScaleKey( (int)params[SCALE_PARAM].getValue() , (int)params[KEY_PARAM].getValue() );
         }
+        quantizer.setScale(scale);
     }
     
     void sendGateOutput(const ProcessArgs& args){
@@ -684,7 +676,7 @@ struct Darius : Module {
                 output = rescale(output, 0.f, 10.f, params[MIN_PARAM].getValue() - 5.f, params[MAX_PARAM].getValue() - 5.f);
             }
             // Then quantize it
-            output = Quantizer::quantize(output, scale);
+            output = quantizer.quantize(output);
         }
 
         // Slide
@@ -703,8 +695,8 @@ struct Darius : Module {
 
         // Clean up by request only
         if (lightsReset) {
-            for (int i = 0; i < 36; i++) lights[CV_LIGHT + i].setBrightness( 0.f );
-            for (int i = 0; i < 8; i++) {
+            for (int i = 0; i < NODES; i++) lights[CV_LIGHT + i].setBrightness( 0.f );
+            for (int i = 0; i < STEPS; i++) {
                 if (pathTraveled[i] >= 0) lights[CV_LIGHT + pathTraveled[i]].setBrightness( 1.f );
             }
             lightsReset = false;
@@ -713,40 +705,38 @@ struct Darius : Module {
         // Using an intermediary to prevent flicker
         lights[CV_LIGHT + pathTraveled[step]].setBrightness( 1.f );
 
-        float brightness[36];
-        // Light the outputs depending on amount of steps enabled
-        brightness[0] = (stepFirst <= 1 && stepLast >= 1 ) ? 1.f : 0.f ;
-        for (int i = STEP2START; i < STEP3START; i++)
-            brightness[i] = (stepFirst <= 2 && stepLast >= 2 ) ? 1.f : 0.f;
-        for (int i = STEP3START; i < STEP4START; i++)
-            brightness[i] = (stepFirst <= 3 && stepLast >= 3 ) ? 1.f : 0.f;
-        for (int i = STEP4START; i < STEP5START; i++)
-            brightness[i] = (stepFirst <= 4 && stepLast >= 4 ) ? 1.f : 0.f;
-        for (int i = STEP5START; i < STEP6START; i++)
-            brightness[i] = (stepFirst <= 5 && stepLast >= 5 ) ? 1.f : 0.f;
-        for (int i = STEP6START; i < STEP7START; i++)
-            brightness[i] = (stepFirst <= 6 && stepLast >= 6 ) ? 1.f : 0.f;
-        for (int i = STEP7START; i < STEP8START; i++)
-            brightness[i] = (stepFirst <= 7 && stepLast >= 7 ) ? 1.f : 0.f;
-        for (int i = STEP8START; i < STEP9START; i++)
-            brightness[i] = (stepFirst <= 8 && stepLast >= 8 ) ? 1.f : 0.f;
-        // And turn off nodes that are impossible to reach
-        for (int i = 0; i < 36; i++)
-            if (probabilities[i] == 0.f) brightness[i] = 0.f;
-
-        for (int i = 0; i < 36; i++)
-            lights[GATE_LIGHT + i].setBrightness(brightness[i]);
-        
+        // The gate lights only change with the step range or the routes
+        if (stepFirst != litStepFirst or stepLast != litStepLast) {
+            litStepFirst = stepFirst;
+            litStepLast = stepLast;
+            gateLightsDirty = true;
+        }
+        if (!gateLightsDirty) return;
+        gateLightsDirty = false;
+
+        // Light the outputs depending on amount of steps enabled,
+        // and turn off nodes that are impossible to reach
+        for (int s = 0; s < STEPS; s++) {
+            bool enabled = (stepFirst <= s + 1 && stepLast >= s + 1);
+            for (int i = Triangle::stepStart(s); i < Triangle::stepStart(s + 1); i++) {
+                float brightness = (enabled && probabilities[i] != 0.f) ? 1.f : 0.f;
+                if (brightness != gateBrightness[i]) {
+                    gateBrightness[i] = brightness;
+                    lights[GATE_LIGHT + i].setBrightness(brightness);
+                }
+            }
+        }
     }
 
     // Sets the lcdStatus according to the lcdMode.
     void updateLcd(const ProcessArgs& args){
+        PROFILE_SCOPE(profile, PROFILE_UPDATE_LCD);
 
         // Updating multiple times a variable that gets read such as lcdText2 causes crashes due to reasons.
         // Use temporary variables instead and write only once. 
         std::string text, relative, absolute;
         float f;
-        std::array<bool, 12> validNotes;
+        Quantizer::ScaleMask validNotes;
 
         // Since we might be sliding, refresh at least this often
         lcdStatus.lcdDirty = true;
@@ -763,7 +753,22 @@ struct Darius : Module {
 
         // Default mode = pick the relevant one instead
         if(lcdMode == DEFAULT_MODE) {
-            lcdMode = (params[QUANTIZE_TOGGLE_PARAM].getValue() == 0.f) ? CV_MODE : QUANTIZED_MODE;
+            if (previewNextRoute) {
+                lcdMode = PREVIEW_MODE;
+            } else {
+                lcdMode = (params[QUANTIZE_TOGGLE_PARAM].getValue() == 0.f) ? CV_MODE : QUANTIZED_MODE;
+            }
+        }
+
+        // The moves of the next route between the first and last step, as far as they fit
+        if (lcdMode == PREVIEW_MODE) {
+            lcdStatus.lcdLayout = Lcd::TEXT1_AND_TEXT2_LAYOUT;
+            lcdStatus.lcdText1 = "NEXT ROUTE:";
+            text = "";
+            for (int i = stepFirst; i < stepLast && text.size() < 11; i++) {
+                text += (upcomingPath[i] == upcomingPath[i - 1] + i) ? "^" : "V";
+            }
+            lcdStatus.lcdText2 = (text.empty()) ? "-" : text;
         }
 
         if (lcdMode == SLIDE_MODE) {
@@ -798,7 +803,7 @@ struct Darius : Module {
                 text = "EXTERNAL";
             }
             lcdStatus.lcdText2 = text;
-            lcdStatus.pianoDisplay = scale;
+            lcdStatus.pianoDisplay = scale.toArray();
         }
 
         if (lcdMode == QUANTIZED_MODE){
@@ -872,12 +877,12 @@ struct Darius : Module {
                 relative.resize(4);
                 relative.append("%");
             }
-            if (probabilities[getUpChild(lastRouteChanged)] >= 0.1f) {
-                absolute = std::to_string(roundf(probabilities[getUpChild(lastRouteChanged)] * 1000.f) / 10.f);
+            if (probabilities[Triangle::upChild(lastRouteChanged)] >= 0.1f) {
+                absolute = std::to_string(roundf(probabilities[Triangle::upChild(lastRouteChanged)] * 1000.f) / 10.f);
             } else {
-                absolute = std::to_string(roundf(probabilities[getUpChild(lastRouteChanged)] * 10000.f) / 100.f);
+                absolute = std::to_string(roundf(probabilities[Triangle::upChild(lastRouteChanged)] * 10000.f) / 100.f);
             }
-            if (probabilities[getUpChild(lastRouteChanged)] >= 0.9999f){
+            if (probabilities[Triangle::upChild(lastRouteChanged)] >= 0.9999f){
                 absolute.resize(3);
                 absolute.append(" %");
             } else {
@@ -895,12 +900,12 @@ struct Darius : Module {
                 relative.resize(4);
                 relative.append("%");
             }
-            if (probabilities[getUpChild(lastRouteChanged)] >= 0.1f) {
-                absolute = std::to_string(roundf(probabilities[getDownChild(lastRouteChanged)] * 1000.f) / 10.f);
+            if (probabilities[Triangle::upChild(lastRouteChanged)] >= 0.1f) {
+                absolute = std::to_string(roundf(probabilities[Triangle::downChild(lastRouteChanged)] * 1000.f) / 10.f);
             } else {
-                absolute = std::to_string(roundf(probabilities[getDownChild(lastRouteChanged)] * 10000.f) / 100.f);
+                absolute = std::to_string(roundf(probabilities[Triangle::downChild(lastRouteChanged)] * 10000.f) / 100.f);
             }
-            if (probabilities[getDownChild(lastRouteChanged)] >= 0.9999f){
+            if (probabilities[Triangle::downChild(lastRouteChanged)] >= 0.9999f){
                 absolute.resize(3);
                 absolute.append(" %");
             } else {
@@ -916,7 +921,7 @@ struct Darius : Module {
         node = 0;
         lastNode = 0;
         pathTraveled[0] = 0;
-        for (int i = 1; i < 8; i++) pathTraveled[i] = -1;
+        for (int i = 1; i < STEPS; i++) pathTraveled[i] = -1;
         lightsReset = true;
         lcdMode = INIT_MODE;
         lcdStatus.lcdLayout = Lcd::TEXT1_AND_TEXT2_LAYOUT;
@@ -928,6 +933,8 @@ struct Darius : Module {
     }
 
     void process(const ProcessArgs& args) override {
+        PROFILE_SCOPE(profile, PROFILE_PROCESS);
+
         if (copyPortableSequence)
             exportPortableSequence(args);
 
@@ -967,8 +974,6 @@ struct Darius : Module {
         setRunStatus(args);
         setStepStatus(args);
 
-        updateRoutes(args);
-
         // Refreshing slide knobs often has a performance impact
         // so the divider will remain quite high unless someone complains
         // it breaks their art. 
@@ -987,12 +992,17 @@ struct Darius : Module {
         setVoltageOutput(args);
         
         if (displayDivider.process()) {
+            updateRoutes(args);
+            updateUpcomingPath(args);
             updateLights(args);
             updateLcd(args);
         }
     }
 };
 
+// Only the 8-step Darius ships, there's no panel for a longer tree (16 rows of knobs would be taller than the rack).
+// The routing in routes.hpp works for any size, the widget below only knows Darius<8>.
+
 
 
 
@@ -1016,8 +1026,8 @@ struct AriaKnob820Snap : AriaKnob820 {
 
 struct AriaKnob820Lcd : AriaKnob820 {
     void onDragMove(const event::DragMove& e) override {
-         dynamic_cast<Darius*>(paramQuantity->module)->lcdLastInteraction = 0.f;
-         dynamic_cast<Darius*>(paramQuantity->module)->lcdStatus.lcdDirty = true;
+         dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdLastInteraction = 0.f;
+         dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdStatus.lcdDirty = true;
         AriaKnob820::onDragMove(e);
     }
 };
@@ -1025,7 +1035,7 @@ struct AriaKnob820Lcd : AriaKnob820 {
 
 struct AriaKnob820MinMax : AriaKnob820Lcd {
     void onDragMove(const event::DragMove& e) override {
-         dynamic_cast<Darius*>(paramQuantity->module)->lcdMode = MINMAX_MODE;
+         dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdMode = MINMAX_MODE;
         AriaKnob820Lcd::onDragMove(e);
     }
 };
@@ -1036,30 +1046,30 @@ struct AriaKnob820Scale : AriaKnob820Lcd {
         AriaKnob820();
     }
     void onDragMove(const event::DragMove& e) override {
-       dynamic_cast<Darius*>(paramQuantity->module)->lcdMode = SCALE_MODE;
+       dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdMode = SCALE_MODE;
         AriaKnob820Lcd::onDragMove(e);
     }
 };
 
 struct AriaKnob820Slide : AriaKnob820Lcd {
     void onDragMove(const event::DragMove& e) override {
-        dynamic_cast<Darius*>(paramQuantity->module)->lcdMode = SLIDE_MODE;
+        dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdMode = SLIDE_MODE;
         AriaKnob820Lcd::onDragMove(e);
     }
 };
 
 struct AriaRockerSwitchHorizontal800ModeReset : AriaRockerSwitchHorizontal800 {
     void onDragStart(const event::DragStart& e) override {
-        dynamic_cast<Darius*>(paramQuantity->module)->lcdMode = DEFAULT_MODE;
-        dynamic_cast<Darius*>(paramQuantity->module)->lcdLastInteraction = 0.f;
-        dynamic_cast<Darius*>(paramQuantity->module)->lcdStatus.lcdDirty = true;
+        dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdMode = DEFAULT_MODE;
+        dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdLastInteraction = 0.f;
+        dynamic_cast<Darius<8>*>(paramQuantity->module)->lcdStatus.lcdDirty = true;
         AriaRockerSwitchHorizontal800::onDragStart(e);
     }
 };
 
 // Also records the last one changed
 template <class TParamWidget>
-TParamWidget* createMainParam(math::Vec pos, Darius* module, int paramId, int lastChanged) {
+TParamWidget* createMainParam(math::Vec pos, Darius<8>* module, int paramId, int lastChanged) {
     TParamWidget* o = new TParamWidget(module, lastChanged);
     o->box.pos = pos;
     if (module) {
@@ -1069,10 +1079,10 @@ TParamWidget* createMainParam(math::Vec pos, Darius* module, int paramId, int la
 }
 
 struct AriaKnob820Route : AriaKnob820 {
-    Darius *module;
+    Darius<8> *module;
     int lastChanged;
 
-    AriaKnob820Route(Darius* module, int lastChanged) {
+    AriaKnob820Route(Darius<8>* module, int lastChanged) {
         this->module = module;
         this->lastChanged = lastChanged;
         setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/knob-820-arrow.svg")));
@@ -1091,10 +1101,10 @@ struct AriaKnob820Route : AriaKnob820 {
 };
 
 struct AriaKnob820TransparentCV : AriaKnob820Transparent {
-    Darius *module;
+    Darius<8> *module;
     int lastChanged;
 
-    AriaKnob820TransparentCV(Darius* module, int lastChanged) {
+    AriaKnob820TransparentCV(Darius<8>* module, int lastChanged) {
         this->module = module;
         this->lastChanged = lastChanged;
         AriaKnob820Transparent();
@@ -1112,7 +1122,7 @@ struct AriaKnob820TransparentCV : AriaKnob820Transparent {
 } // Namespace DariusWidgets
 
 struct DariusWidget : ModuleWidget {
-    DariusWidget(Darius* module) {
+    DariusWidget(Darius<8>* module) {
         setModule(module);
         setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/faceplates/Darius.svg")));
         
@@ -1127,185 +1137,201 @@ struct DariusWidget : ModuleWidget {
 
         // The main area - lights, knobs and trigger outputs.
         for (int i = 0; i < 1; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec( 4.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius::CV_LIGHT +    i));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec( 4.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius::CV_PARAM +    i, i));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(14.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius::ROUTE_PARAM + i, i));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec( 9.5, (22.5 + (6.5 * 7) + i * 13.0))), module, Darius::GATE_LIGHT +  i));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec( 9.5, (22.5 + (6.5 * 7) + i * 13.0))), module, Darius::GATE_OUTPUT + i));
+            addChild(createLight<AriaInputLight>(mm2px(Vec( 4.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec( 4.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius<8>::CV_PARAM +    i, i));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(14.5, (16.0 + (6.5 * 7) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i, i));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec( 9.5, (22.5 + (6.5 * 7) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec( 9.5, (22.5 + (6.5 * 7) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i));
         }
         for (int i = 0; i < 2; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(24.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP2START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(24.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP2START, i + STEP2START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(34.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP2START, i + STEP2START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(29.5, (22.5 + (6.5 * 6) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP2START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(29.5, (22.5 + (6.5 * 6) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP2START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(24.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP2START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(24.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP2START, i + STEP2START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(34.5, (16.0 + (6.5 * 6) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP2START, i + STEP2START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(29.5, (22.5 + (6.5 * 6) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP2START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(29.5, (22.5 + (6.5 * 6) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP2START));
         }
         for (int i = 0; i < 3; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(44.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP3START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(44.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP3START, i + STEP3START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(54.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP3START, i + STEP3START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(49.5, (22.5 + (6.5 * 5) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP3START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(49.5, (22.5 + (6.5 * 5) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP3START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(44.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP3START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(44.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP3START, i + STEP3START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(54.5, (16.0 + (6.5 * 5) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP3START, i + STEP3START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(49.5, (22.5 + (6.5 * 5) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP3START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(49.5, (22.5 + (6.5 * 5) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP3START));
         }
         for (int i = 0; i < 4; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(64.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP4START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(64.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP4START, i + STEP4START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(74.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP4START, i + STEP4START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(69.5, (22.5 + (6.5 * 4) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP4START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(69.5, (22.5 + (6.5 * 4) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP4START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(64.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP4START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(64.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP4START, i + STEP4START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(74.5, (16.0 + (6.5 * 4) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP4START, i + STEP4START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(69.5, (22.5 + (6.5 * 4) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP4START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(69.5, (22.5 + (6.5 * 4) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP4START));
         }
         for (int i = 0; i < 5; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(84.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP5START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(84.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP5START, i + STEP5START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(94.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP5START, i + STEP5START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(89.5, (22.5 + (6.5 * 3) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP5START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(89.5, (22.5 + (6.5 * 3) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP5START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(84.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP5START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(84.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP5START, i + STEP5START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(94.5, (16.0 + (6.5 * 3) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP5START, i + STEP5START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(89.5, (22.5 + (6.5 * 3) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP5START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(89.5, (22.5 + (6.5 * 3) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP5START));
         }
         for (int i = 0; i < 6; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(104.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP6START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(104.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP6START, i + STEP6START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(114.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP6START, i + STEP6START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(109.5, (22.5 + (6.5 * 2) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP6START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(109.5, (22.5 + (6.5 * 2) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP6START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(104.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP6START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(104.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP6START, i + STEP6START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(114.5, (16.0 + (6.5 * 2) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP6START, i + STEP6START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(109.5, (22.5 + (6.5 * 2) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP6START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(109.5, (22.5 + (6.5 * 2) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP6START));
         }
         for (int i = 0; i < 7; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(124.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP7START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(124.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP7START, i + STEP7START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(134.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius::ROUTE_PARAM + i + STEP7START, i + STEP7START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(129.5, (22.5 + (6.5 * 1) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP7START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(129.5, (22.5 + (6.5 * 1) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP7START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(124.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP7START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(124.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP7START, i + STEP7START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820Route>(mm2px(Vec(134.5, (16.0 + (6.5 * 1) + i * 13.0))), module, Darius<8>::ROUTE_PARAM + i + STEP7START, i + STEP7START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(129.5, (22.5 + (6.5 * 1) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP7START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(129.5, (22.5 + (6.5 * 1) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP7START));
         }
         for (int i = 0; i < 8; i++) {
-            addChild(createLight<AriaInputLight>(mm2px(Vec(144.5, (16.0 + (6.5 * 0) + i * 13.0))), module, Darius::CV_LIGHT +    i + STEP8START));
-            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(144.5, (16.0 + (6.5 * 0) + i * 13.0))), module, Darius::CV_PARAM +    i + STEP8START, i + STEP8START));
-            addChild(createLight<AriaOutputLight>(mm2px(Vec(149.5, (22.5 + (6.5 * 0) + i * 13.0))), module, Darius::GATE_LIGHT +  i + STEP8START));
-            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(149.5, (22.5 + (6.5 * 0) + i * 13.0))), module, Darius::GATE_OUTPUT + i + STEP8START));
+            addChild(createLight<AriaInputLight>(mm2px(Vec(144.5, (16.0 + (6.5 * 0) + i * 13.0))), module, Darius<8>::CV_LIGHT +    i + STEP8START));
+            addParam(DariusWidgets::createMainParam<DariusWidgets::AriaKnob820TransparentCV>(mm2px(Vec(144.5, (16.0 + (6.5 * 0) + i * 13.0))), module, Darius<8>::CV_PARAM +    i + STEP8START, i + STEP8START));
+            addChild(createLight<AriaOutputLight>(mm2px(Vec(149.5, (22.5 + (6.5 * 0) + i * 13.0))), module, Darius<8>::GATE_LIGHT +  i + STEP8START));
+            addOutput(createOutput<AriaJackTransparent>(mm2px(Vec(149.5, (22.5 + (6.5 * 0) + i * 13.0))), module, Darius<8>::GATE_OUTPUT + i + STEP8START));
         }
         
         // Step < ^ v >
-        addInput(createInput<AriaJackIn>(mm2px(Vec(4.5, 22.5)), module, Darius::STEP_BACK_INPUT));
-        addInput(createInput<AriaJackIn>(mm2px(Vec(14.5, 18.0)), module, Darius::STEP_UP_INPUT));
-        addInput(createInput<AriaJackIn>(mm2px(Vec(14.5, 27.0)), module, Darius::STEP_DOWN_INPUT));
-        addInput(createInput<AriaJackIn>(mm2px(Vec(24.5, 22.5)), module, Darius::STEP_INPUT));
-        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(24.5, 32.5)), module, Darius::STEP_PARAM));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(4.5, 22.5)), module, Darius<8>::STEP_BACK_INPUT));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(14.5, 18.0)), module, Darius<8>::STEP_UP_INPUT));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(14.5, 27.0)), module, Darius<8>::STEP_DOWN_INPUT));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(24.5, 22.5)), module, Darius<8>::STEP_INPUT));
+        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(24.5, 32.5)), module, Darius<8>::STEP_PARAM));
         
         // Run
-        addInput(createInput<AriaJackIn>(mm2px(Vec(4.5, 42.5)), module, Darius::RUN_INPUT));
-        addParam(createParam<AriaPushButton820>(mm2px(Vec(14.5, 42.5)), module, Darius::RUN_PARAM));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(4.5, 42.5)), module, Darius<8>::RUN_INPUT));
+        addParam(createParam<AriaPushButton820>(mm2px(Vec(14.5, 42.5)), module, Darius<8>::RUN_PARAM));
         
         // Reset
-        addInput(createInput<AriaJackIn>(mm2px(Vec(24.5, 42.5)), module, Darius::RESET_INPUT));
-        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(34.5, 42.5)), module, Darius::RESET_PARAM));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(24.5, 42.5)), module, Darius<8>::RESET_INPUT));
+        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(34.5, 42.5)), module, Darius<8>::RESET_PARAM));
         
         // Step count & First step
-        addParam(createParam<DariusWidgets::AriaKnob820Snap>(mm2px(Vec(44.5, 22.5)), module, Darius::STEPFIRST_PARAM));
-        addParam(createParam<DariusWidgets::AriaKnob820Snap>(mm2px(Vec(54.5, 22.5)), module, Darius::STEPCOUNT_PARAM));
+        addParam(createParam<DariusWidgets::AriaKnob820Snap>(mm2px(Vec(44.5, 22.5)), module, Darius<8>::STEPFIRST_PARAM));
+        addParam(createParam<DariusWidgets::AriaKnob820Snap>(mm2px(Vec(54.5, 22.5)), module, Darius<8>::STEPCOUNT_PARAM));
         
         // Randomize
-        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(64.5, 22.5)), module, Darius::RANDCV_PARAM));
-        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(74.5, 22.5)), module, Darius::RANDROUTE_PARAM));
+        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(64.5, 22.5)), module, Darius<8>::RANDCV_PARAM));
+        addParam(createParam<AriaPushButton820Momentary>(mm2px(Vec(74.5, 22.5)), module, Darius<8>::RANDROUTE_PARAM));
         
         // Seed
-        addParam(createParam<AriaRockerSwitchVertical800>(mm2px(Vec(103.0, 112.0)), module, Darius::SEED_MODE_PARAM));
-        addInput(createInput<AriaJackIn>(mm2px(Vec(109.5, 112.0)), module, Darius::SEED_INPUT));
-        addChild(createLightCentered<SmallLight<InputLight>>(mm2px(Vec(108.7, 121.4)), module, Darius::SEED_LIGHT));
+        addParam(createParam<AriaRockerSwitchVertical800>(mm2px(Vec(103.0, 112.0)), module, Darius<8>::SEED_MODE_PARAM));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(109.5, 112.0)), module, Darius<8>::SEED_INPUT));
+        addChild(createLightCentered<SmallLight<InputLight>>(mm2px(Vec(108.7, 121.4)), module, Darius<8>::SEED_LIGHT));
 
         // Output area //////////////////
 
         // LCD
-        Lcd::LcdWidget<Darius> *lcd = new Lcd::LcdWidget<Darius>(module);
+        Lcd::LcdWidget<Darius<8>> *lcd = new Lcd::LcdWidget<Darius<8>>(module);
         lcd->box.pos = mm2px(Vec(10.3f, 106.7f));
         addChild(lcd);
 
         // Quantizer toggle
-        addParam(createParam<DariusWidgets::AriaRockerSwitchHorizontal800ModeReset>(mm2px(Vec(11.1, 99.7)), module, Darius::QUANTIZE_TOGGLE_PARAM));
+        addParam(createParam<DariusWidgets::AriaRockerSwitchHorizontal800ModeReset>(mm2px(Vec(11.1, 99.7)), module, Darius<8>::QUANTIZE_TOGGLE_PARAM));
 
         // Voltage Range
-        addParam(createParam<AriaRockerSwitchHorizontal800Flipped>(mm2px(Vec(28.0, 118.8)), module, Darius::RANGE_PARAM));
+        addParam(createParam<AriaRockerSwitchHorizontal800Flipped>(mm2px(Vec(28.0, 118.8)), module, Darius<8>::RANGE_PARAM));
 
         // Min & Max
-        addParam(createParam<DariusWidgets::AriaKnob820MinMax>(mm2px(Vec(49.5f, 112.f)), module, Darius::MIN_PARAM)); 
-        addParam(createParam<DariusWidgets::AriaKnob820MinMax>(mm2px(Vec(59.5f, 112.f)), module, Darius::MAX_PARAM)); 
+        addParam(createParam<DariusWidgets::AriaKnob820MinMax>(mm2px(Vec(49.5f, 112.f)), module, Darius<8>::MIN_PARAM)); 
+        addParam(createParam<DariusWidgets::AriaKnob820MinMax>(mm2px(Vec(59.5f, 112.f)), module, Darius<8>::MAX_PARAM)); 
 
         // Quantizer Key & Scale
-        addParam(createParam<DariusWidgets::AriaKnob820Scale>(mm2px(Vec(49.5f, 99.f)), module, Darius::KEY_PARAM));
-        addParam(createParam<DariusWidgets::AriaKnob820Scale>(mm2px(Vec(59.5f, 99.f)), module, Darius::SCALE_PARAM));
+        addParam(createParam<DariusWidgets::AriaKnob820Scale>(mm2px(Vec(49.5f, 99.f)), module, Darius<8>::KEY_PARAM));
+        addParam(createParam<DariusWidgets::AriaKnob820Scale>(mm2px(Vec(59.5f, 99.f)), module, Darius<8>::SCALE_PARAM));
 
         // External Scale
-        addInput(createInput<AriaJackIn>(mm2px(Vec(69.5, 99.0)), module, Darius::EXT_SCALE_INPUT));
+        addInput(createInput<AriaJackIn>(mm2px(Vec(69.5, 99.0)), module, Darius<8>::EXT_SCALE_INPUT));
 
         // Slide
-        addParam(createParam<DariusWidgets::AriaKnob820Slide>(mm2px(Vec(69.5, 112.0)), module, Darius::SLIDE_PARAM));
+        addParam(createParam<DariusWidgets::AriaKnob820Slide>(mm2px(Vec(69.5, 112.0)), module, Darius<8>::SLIDE_PARAM));
 
         // Output!
-        addOutput(createOutput<AriaJackOut>(mm2px(Vec(79.5, 112.0)), module, Darius::GLOBAL_GATE_OUTPUT));
-        addOutput(createOutput<AriaJackOut>(mm2px(Vec(89.5, 112.0)), module, Darius::CV_OUTPUT));
+        addOutput(createOutput<AriaJackOut>(mm2px(Vec(79.5, 112.0)), module, Darius<8>::GLOBAL_GATE_OUTPUT));
+        addOutput(createOutput<AriaJackOut>(mm2px(Vec(89.5, 112.0)), module, Darius<8>::CV_OUTPUT));
     }
 
 
     struct CopyPortableSequenceItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->copyPortableSequence = true;
         }
     };
 
     struct PastePortableSequenceItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->pastePortableSequence = true;
         }
     };
 
+    struct PreviewNextRouteItem : MenuItem {
+        Darius<8> *module;
+        void onAction(const event::Action &e) override {
+            module->previewNextRoute = !module->previewNextRoute;
+            module->lcdMode = DEFAULT_MODE;
+            module->lcdStatus.lcdDirty = true;
+        }
+    };
+
+    struct LegacySeedsItem : MenuItem {
+        Darius<8> *module;
+        void onAction(const event::Action &e) override {
+            module->setLegacySeeds(!module->legacySeeds);
+        }
+    };
+
     struct ResetCVItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->resetCV = true;
         }
     };
 
     struct ResetRoutesItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->resetRoutes = true;
         }
     };
 
     struct RoutesToTopItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->routesToTop = true;
         }
     };
 
     struct RoutesToBottomItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->routesToBottom = true;
         }
     };
 
     struct RoutesToEqualProbabilityItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->routesToEqualProbability = true;
         }
     };
 
     struct RoutesToBinaryTreeItem : MenuItem {
-        Darius *module;
+        Darius<8> *module;
         void onAction(const event::Action &e) override {
             module->routesToBinaryTree = true;
         }
     };
 
     void appendContextMenu(ui::Menu *menu) override {	
-        Darius *module = dynamic_cast<Darius*>(this->module);
+        Darius<8> *module = dynamic_cast<Darius<8>*>(this->module);
         assert(module);
 
         menu->addChild(new MenuSeparator());
 
-        CopyPortableSequenceItem *copyPortableSequenceItem = createMenuItem<CopyPortableSequenceItem>("Copy one possible route as Portable Sequence");
+        CopyPortableSequenceItem *copyPortableSequenceItem = createMenuItem<CopyPortableSequenceItem>("Copy the next route as Portable Sequence");
         copyPortableSequenceItem->module = module;
         menu->addChild(copyPortableSequenceItem);
 
@@ -1315,6 +1341,16 @@ struct DariusWidget : ModuleWidget {
 
         MenuLabel *pasteNotes = createMenuLabel<MenuLabel>("After pasting, set MIN/MAX knobs to maximum range");
         menu->addChild(pasteNotes);
+
+        menu->addChild(new MenuSeparator());
+
+        PreviewNextRouteItem *previewNextRouteItem = createMenuItem<PreviewNextRouteItem>("Preview the next route on the display", CHECKMARK(module->previewNextRoute));
+        previewNextRouteItem->module = module;
+        menu->addChild(previewNextRouteItem);
+
+        LegacySeedsItem *legacySeedsItem = createMenuItem<LegacySeedsItem>("Same routes from a seed as older versions (slower)", CHECKMARK(module->legacySeeds));
+        legacySeedsItem->module = module;
+        menu->addChild(legacySeedsItem);
       
         menu->addChild(new MenuSeparator());
 
@@ -1343,9 +1379,11 @@ struct DariusWidget : ModuleWidget {
         RoutesToBinaryTreeItem *routesToBinaryTree = createMenuItem<RoutesToBinaryTreeItem>("Routes to Binary tree (equal probability)");
         routesToBinaryTree->module = module;
         menu->addChild(routesToBinaryTree);
+
+        Profiler::appendContextMenu(menu, module, module->profile);
     }
 };
 
 } // namespace Darius
 
-Model* modelDarius = createModel<Darius::Darius, Darius::DariusWidget>("Darius");
+Model* modelDarius = createModel<Darius::Darius<8>, Darius::DariusWidget>("Darius");
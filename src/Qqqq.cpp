@@ -14,7 +14,16 @@ You should have received a copy of the GNU General Public License along with thi
 #include "lcd.hpp"
 #include "javascript.hpp"
 #include "javascript-libraries.hpp"
+#include "chords.hpp"
+#include "scenebank.hpp"
+#include "expander.hpp"
+#include <osdialog.h>
 #include "portablesequence.hpp"
+#include "profiler.hpp"
+#include "scheduler.hpp"
+#include "handoff.hpp"
+#include <memory>
+#include <mutex>
 
 namespace Qqqq {
 
@@ -33,9 +42,212 @@ enum LcdModes {
 
 // Nope, not gonna give you a placebo "HIGH CPU" right click option unless people
 // raise valid complaints about this divider. 
+//
+// Audio rate mode quantizes every sample and follows the scene CV sample by sample.
+// The divider still paces UI-driven updates.
 const int PROCESSDIVIDER = 32;
 const int LCDDIVIDER = 512;
 
+// Both imports share one pooled runtime, so Tonal.js & co. only get loaded once per session.
+// Only used when Tonal.js parsing is enabled, chords.hpp does the same thing natively.
+inline const std::vector<std::string>& importLibraries() {
+    static const std::vector<std::string> libraries = {
+        JavascriptLibraries::TONALJS,
+        JavascriptLibraries::TOKENIZE,
+        JavascriptLibraries::TOSCALEPOSITION,
+        JavascriptLibraries::PARSEASLEADSHEET,
+        JavascriptLibraries::LEADSHEETTOQQQQ,
+        JavascriptLibraries::ROMANTOQQQQ
+    };
+    return libraries;
+}
+
+// A whole bank of scenes parsed off the audio thread, ready to be swapped in.
+// Pastes go through here too, so that only the audio thread ever writes the scenes.
+struct ImportedBank {
+    bool valid = false;
+    std::array<Quantizer::ScaleMask, 16> scale;
+    // -1 replaces the whole bank, otherwise only that scene, from scale[slot]
+    int slot = -1;
+    // What the LCD says once it's applied. A literal, so showing it doesn't allocate.
+    const char* lcdText = " Imported!";
+};
+
+inline ImportedBank bankFromProgression(const Chords::Progression& progression) {
+    ImportedBank bank;
+    bank.scale = SceneBank::scalesFromProgression(progression);
+    bank.valid = true;
+    return bank;
+}
+
+// Chords, not portable sequences. Format is like:
+// [[0,4,7],[2,6,9],[4,8,11],[5,9,12],[7,11,2],[9,1,4],[11,3,6]]
+inline ImportedBank parseBank(const std::string& json) {
+    json_error_t error;
+    json_t* rootJ = json_loads(json.c_str(), 0, &error);
+    if (!rootJ) return ImportedBank();
+    Chords::Progression progression(json_array_size(rootJ));
+    for (size_t i = 0; i < progression.size(); i++) {
+        json_t* scaleJ = json_array_get(rootJ, i);
+        for (size_t j = 0; j < json_array_size(scaleJ); j++) {
+            progression[i].push_back(json_integer_value(json_array_get(scaleJ, j)));
+        }
+    }
+    json_decref(rootJ);
+    return bankFromProgression(progression);
+}
+
+// Shared between a module and its import threads, so it outlives the module if it has to.
+// Any number of threads may be parsing at once; the mutex makes them take turns publishing,
+// so the slot still only ever has one producer at a time. The audio thread never touches the mutex.
+struct Importer {
+    std::mutex producerMutex;
+    Handoff::Slot<ImportedBank> slot;
+};
+
+inline void publishImport(Importer& importer, const ImportedBank& bank) {
+    std::lock_guard<std::mutex> lock(importer.producerMutex);
+    importer.slot.writeBuffer() = bank;
+    importer.slot.publish();
+}
+
+// Runs on the Javascript pool's thread: the JS is slow, the first time especially, and must not freeze the UI.
+inline void importInBackground(std::shared_ptr<Importer> importer, std::string script) {
+    Javascript::pool().post(importLibraries(), [importer, script](Javascript::Runtime& js) {
+        // The runtime is shared, so a script that fails must not pick up the last import's results
+        js.evaluateString("results = undefined");
+        if (! js.evaluateString(script)) WARN("Qqqq: import failed: %s", js.lastError.c_str());
+        publishImport(*importer, parseBank(js.readVariableAsString("results")));
+    });
+}
+
+// The 16 scenes, a mask each. Writes go through set() so the table keeps track of the last scene
+// that isn't empty, and of which scenes changed since their quantizer was last built.
+struct SceneTable {
+    std::array<Quantizer::ScaleMask, 16> masks;
+    // The last scene that isn't empty, 0 if they all are
+    int last = 0;
+    // One bit per scene
+    uint16_t dirty = 0xffff;
+
+    const Quantizer::ScaleMask& operator[](int scene) const {
+        return masks[scene];
+    }
+
+    void set(int scene, const Quantizer::ScaleMask& mask) {
+        if (mask == masks[scene]) return;
+        masks[scene] = mask;
+        dirty |= 1 << scene;
+        if (! mask.empty()) {
+            if (scene > last) last = scene;
+        } else if (scene == last) {
+            // Only emptying the last scene costs a scan
+            while (last > 0 and masks[last].empty()) last--;
+        }
+    }
+
+    void setNote(int scene, int note, bool valid = true) {
+        Quantizer::ScaleMask mask = masks[scene];
+        mask.set(note, valid);
+        set(scene, mask);
+    }
+
+    void assign(const std::array<Quantizer::ScaleMask, 16>& scenes) {
+        for (int i = 0; i < 16; i++) set(i, scenes[i]);
+    }
+
+    void clear() {
+        for (int i = 0; i < 16; i++) set(i, Quantizer::ScaleMask());
+    }
+
+    int lastNonEmpty() const {
+        return last;
+    }
+};
+
+// Scene CV to scene, 0V~10V
+inline int sceneOfVoltage(float voltage) {
+    return clamp((int) rescale(voltage, 0.f, 10.f, 0.f, 15.2f), 0, 15);
+}
+
+// One column's knobs and switches, compiled down to what the quantizing loop actually needs.
+// Read at process divider ticks, so the audio rate path doesn't go through the params every sample,
+// and only recompiled when one of the knobs moved.
+// The quantizers are per channel: the same one 16 times over unless each channel picks its own scene.
+struct Column;
+typedef void (*ColumnFunction)(const Column& column, const Quantizer::Engine* const* quantizers, float* voltage, int channels);
+
+struct Column {
+    bool outputConnected = false;
+    bool visualize = false;
+    bool shConnected = false;
+    bool trackAndHold = false;
+    // The knobs as they were last compiled
+    float scaling = NAN;
+    float offset = NAN;
+    float transpose = NAN;
+    float transposeMode = NAN;
+    bool perChannel = false;
+    // Compiled
+    float gain = 1.f;
+    float bias = 0.f;
+    int scaleDegrees = 0;
+    float octaves = 0.f;
+    ColumnFunction function = NULL;
+
+    void compile();
+};
+
+// Scaling, offset and semitone transposition are a single multiply-add, done before quantizing.
+// Scale degree transposition happens while quantizing.
+// Octave transposition is done after, without going past 5V: instead of adding one octave at a time
+// and checking, it adds as many octaves as fit at once. A lane is 5V or less going up,
+// -5V or more going down, and moves by one more octave for each whole volt left before that limit.
+template <bool SCALE_DEGREES, int OCTAVE_DIRECTION>
+void quantizeColumn(const Column& column, const Quantizer::Engine* const* quantizers, float* voltage, int channels) {
+    for (int c = 0; c < channels; c += 4) {
+        simd::float_4 v = simd::float_4::load(voltage + c);
+        v = simd::clamp(v * column.gain + column.bias, -5.f, 5.f);
+        v = quantizers[0]->quantize(v, SCALE_DEGREES ? column.scaleDegrees : 0);
+        if (OCTAVE_DIRECTION > 0) v += simd::fmin(simd::float_4(column.octaves), simd::fmax(simd::floor(5.f - v) + 1.f, simd::float_4(0.f)));
+        if (OCTAVE_DIRECTION < 0) v -= simd::fmin(simd::float_4(column.octaves), simd::fmax(simd::floor(v + 5.f) + 1.f, simd::float_4(0.f)));
+        v.store(voltage + c);
+    }
+}
+
+// Same thing one channel at a time, each through the quantizer of its own scene
+template <bool SCALE_DEGREES, int OCTAVE_DIRECTION>
+void quantizeColumnPerChannel(const Column& column, const Quantizer::Engine* const* quantizers, float* voltage, int channels) {
+    for (int c = 0; c < channels; c++) {
+        float v = clamp(voltage[c] * column.gain + column.bias, -5.f, 5.f);
+        v = quantizers[c]->quantize(v, SCALE_DEGREES ? column.scaleDegrees : 0);
+        if (OCTAVE_DIRECTION > 0) v += std::fmin(column.octaves, std::fmax(std::floor(5.f - v) + 1.f, 0.f));
+        if (OCTAVE_DIRECTION < 0) v -= std::fmin(column.octaves, std::fmax(std::floor(v + 5.f) + 1.f, 0.f));
+        voltage[c] = v;
+    }
+}
+
+inline void Column::compile() {
+    // Transpose mode 1: Semitones, before quantizing
+    gain = scaling / 100.f;
+    bias = offset + ((transposeMode == 1.f) ? transpose / 12.f : 0.f);
+    // Transpose mode 2: Scale degrees, while quantizing
+    scaleDegrees = (transposeMode == 2.f) ? (int) transpose : 0;
+    // Transpose mode 0: Octaves, after quantizing
+    int octaveShift = (transposeMode == 0.f) ? (int) transpose : 0;
+    octaves = (float) abs(octaveShift);
+    if (scaleDegrees != 0) {
+        function = perChannel ? quantizeColumnPerChannel<true, 0> : quantizeColumn<true, 0>;
+    } else if (octaveShift > 0) {
+        function = perChannel ? quantizeColumnPerChannel<false, 1> : quantizeColumn<false, 1>;
+    } else if (octaveShift < 0) {
+        function = perChannel ? quantizeColumnPerChannel<false, -1> : quantizeColumn<false, -1>;
+    } else {
+        function = perChannel ? quantizeColumnPerChannel<false, 0> : quantizeColumn<false, 0>;
+    }
+}
+
+
 struct Qqqq : Module {
     enum ParamIds {
         ENUMS(NOTE_PARAM, 12),
@@ -72,12 +284,21 @@ struct Qqqq : Module {
 
     bool lastExtInConnected = false;
     bool sceneChanged = false;
-    // FIXME: I am supposed to free it manually but didn't figure out how.
-    // FIXME: IDK how to use a std::array for this - assuming I even can
-    bool leftMessages[2][12];
+    // What we show the module on our right
+    ::Expander::ScaleOutlet outlet;
     bool isExpander = false;
-    bool lastIsExpander = false;
     bool sceneTrigSelection = false;
+    // Each channel of the scene input picks the scene of the same channel of the CV inputs
+    bool scenePolySelection = false;
+    // Whether that's actually happening right now, the scene input must be connected too
+    bool perChannelScenes = false;
+    // Native parsing does the same thing as Tonal.js in microseconds, this is only a fallback
+    bool tonalJsImport = false;
+    // Channel 2 of the scene input picks a bank from the library, channel 1 still picks the scene
+    bool libraryCvSelection = false;
+    // Quantize every sample instead of every PROCESSDIVIDER samples
+    bool audioRate = false;
+    int cvBank = -1;
     int lcdMode = INIT_MODE;
     int scene = 0;
     int lastScene = 0;
@@ -89,18 +310,30 @@ struct Qqqq : Module {
     float lcdLastInteraction = 0.f;
     float lastKeyKnob = 0.f;
     float lastScaleKnob = 2.f;
-    std::array<std::array<bool, 12>, 16> scale;
-    std::array<bool, 12> lastExternalScale;
+    SceneTable scale;
+    Quantizer::ScaleMask lastExternalScale;
     std::array<bool, 12> litKeys;
-    std::array<bool, 12> receivedExpanderScale;
-    std::array<bool, 12> lastReceivedExpanderScale;
+    ::Expander::ScaleMessage receivedExpanderScale;
+    // 0 while we're not an expander, so we pick up the scale as soon as we become one
+    uint64_t appliedExpanderGeneration = 0;
     std::array<std::array<float, 16>, 4> inputVoltage;
     std::array<std::array<float, 16>, 4> shVoltage;
     std::array<int, 4> inputChannels;
     std::array<int, 4> shChannels;
+    std::array<Column, 4> columns;
+    // What the external scale output currently shows, so it's only written when that changes
+    Quantizer::ScaleMask lastOutputScale;
+    int lastOutputKey = -1;
     Lcd::LcdStatus lcdStatus;
-    dsp::ClockDivider processDivider;
-    dsp::ClockDivider lcdDivider;
+    // One per scene, only rebuilt when the scene changed. Switching scenes costs nothing.
+    std::array<Quantizer::Engine, 16> quantizers;
+    // What each channel gets quantized with
+    std::array<const Quantizer::Engine*, 16> channelQuantizers;
+    enum ProfileIds { PROFILE_PROCESS, PROFILE_QUANTIZER_COLUMN, PROFILE_UPDATE_LCD, NUM_PROFILES };
+    Profiler::Profile profile {"process", "processQuantizerColumn", "updateLcd"};
+    Scheduler::Divider processDivider;
+    Scheduler::Divider lcdDivider;
+    std::shared_ptr<Importer> importer = std::make_shared<Importer>();
     dsp::SchmittTrigger shTrigger[4];
     dsp::SchmittTrigger sceneSelectionTrigger;
     
@@ -142,12 +375,15 @@ struct Qqqq : Module {
         lcdStatus.lcdText1 = " Q- ...";
         lcdStatus.lcdLayout = Lcd::TEXT1_LAYOUT;
         // Initialize
-        for (int i = 0; i < 16; i++) { for (int j = 0; j < 12; j++) { scale[i][j] = false; }}
+        scale.clear();
         // C Minor in first scene
-        scale[0][0] = true; scale[0][2] = true; scale[0][3] = true; scale[0][5] = true; scale[0][7] = true; scale[0][8] = true; scale[0][10] = true;
+        scale.set(0, Quantizer::validNotesInScale(Quantizer::NATURAL_MINOR));
+        channelQuantizers.fill(&quantizers[0]);
         // Expander
-        leftExpander.producerMessage = leftMessages[0];
-        leftExpander.consumerMessage = leftMessages[1];
+        rightExpander.producerMessage = &outlet;
+        updateColumns();
+        // Loads the library now, rather than on the audio thread the first time it's needed
+        SceneBank::store();
     }
 
 
@@ -155,6 +391,10 @@ struct Qqqq : Module {
         json_t* rootJ = json_object();
 
         json_object_set_new(rootJ, "sceneTrigSelection", json_boolean(sceneTrigSelection));
+        json_object_set_new(rootJ, "scenePolySelection", json_boolean(scenePolySelection));
+        json_object_set_new(rootJ, "tonalJsImport", json_boolean(tonalJsImport));
+        json_object_set_new(rootJ, "libraryCvSelection", json_boolean(libraryCvSelection));
+        json_object_set_new(rootJ, "audioRate", json_boolean(audioRate));
         json_object_set_new(rootJ, "scene", json_integer(scene));
 
         json_t* scenesJ = json_array();
@@ -174,6 +414,18 @@ struct Qqqq : Module {
         json_t* sceneTrigSelectionJ = json_object_get(rootJ, "sceneTrigSelection");
         if (sceneTrigSelectionJ) sceneTrigSelection = json_boolean_value(sceneTrigSelectionJ);
 
+        json_t* scenePolySelectionJ = json_object_get(rootJ, "scenePolySelection");
+        if (scenePolySelectionJ) scenePolySelection = json_boolean_value(scenePolySelectionJ);
+
+        json_t* tonalJsImportJ = json_object_get(rootJ, "tonalJsImport");
+        if (tonalJsImportJ) tonalJsImport = json_boolean_value(tonalJsImportJ);
+
+        json_t* libraryCvSelectionJ = json_object_get(rootJ, "libraryCvSelection");
+        if (libraryCvSelectionJ) libraryCvSelection = json_boolean_value(libraryCvSelectionJ);
+
+        json_t* audioRateJ = json_object_get(rootJ, "audioRate");
+        if (audioRateJ) audioRate = json_boolean_value(audioRateJ);
+
         json_t* sceneJ = json_object_get(rootJ, "scene");
         if (sceneJ) scene = json_integer_value(sceneJ);
 
@@ -184,7 +436,7 @@ struct Qqqq : Module {
                 if (sceneJ) {
                     for (int j = 0; j < 12; j++) {
                         json_t* noteJ = json_array_get(sceneJ, j);
-                        scale[i][j] = json_boolean_value(noteJ);
+                        scale.setNote(i, j, json_boolean_value(noteJ));
                     }
                 }
             }
@@ -194,15 +446,13 @@ struct Qqqq : Module {
     }
 
     void onReset() override {
+        scale.clear();
         for (int i = 1; i < 16; i++) {
-            for (int j = 0; j < 12; j++) {
-                scale[i][j] = false;
-            }
             params[SCENE_BUTTON_PARAM + i].setValue(0.f);
         }
         params[SCENE_BUTTON_PARAM + 0].setValue(1.f);
         // C Minor in first scene
-        scale[0][0] = true; scale[0][2] = true; scale[0][3] = true; scale[0][5] = true; scale[0][7] = true; scale[0][8] = true; scale[0][10] = true;
+        scale.set(0, Quantizer::validNotesInScale(Quantizer::NATURAL_MINOR));
         scene = 0;
         scaleToPiano();
         lcdStatus.lcdText1 = " Q- ???";
@@ -215,7 +465,7 @@ struct Qqqq : Module {
         for (int i = 0; i < 16; i++) {
             for (int j = 0; j < 12; j++) {
                 // Should produce about 7 notes per scale
-                scale[i][j] = (random::uniform() > 0.42f) ? true : false;
+                scale.setNote(i, j, random::uniform() > 0.42f);
             }
             params[SCENE_BUTTON_PARAM + i].setValue(0.f);
         }
@@ -227,35 +477,26 @@ struct Qqqq : Module {
         lcdStatus.lcdDirty = true;
     }
 
-    // Chords, not portable sequences. Format is like:
-    // [[0,4,7],[2,6,9],[4,8,11],[5,9,12],[7,11,2],[9,1,4],[11,3,6]]
-    void importJson(const char* &jsonC) {
-        json_error_t error;
-        json_t* rootJ = json_loads(jsonC, 0, &error);
-        if (!rootJ) {
+    // Picks up a bank parsed in the background, if there's one.
+    // Takes effect at the next process divider tick after parsing finishes, so within PROCESSDIVIDER samples.
+    void applyImport() {
+        ImportedBank* bank = importer->slot.consume();
+        if (!bank) return;
+        if (!bank->valid) {
             lcdStatus.lcdText1 = "!! ERROR !!";
             lcdLastInteraction = 0.f;
             lcdMode = INIT_MODE;
             lcdStatus.lcdDirty = true;
-        } else {
-            for (int i = 0; i < 16; i++) {
-                for (int j = 0; j < 12; j++) {
-                    scale[i][j] = false;
-                }
-            }
-            size_t scenesJSize = json_array_size(rootJ);
-            if (scenesJSize > 16) scenesJSize = 16;
-            for (size_t i = 0; i < scenesJSize; i++) {
-                json_t* scaleJ = json_array_get(rootJ, i);
-                size_t scaleJSize = json_array_size(scaleJ);
-                for (size_t j = 0; j < scaleJSize; j++) {
-                    json_t* noteJ = json_array_get(scaleJ, j);
-                    int note = json_integer_value(noteJ);
-                    scale[i][note] = true;
-                }
-            }
+        } else if (bank->slot >= 0) {
+            scale.set(bank->slot, bank->scale[bank->slot]);
             scaleToPiano();
-            lcdStatus.lcdText1 = " Imported!";
+            lcdStatus.lcdText1 = bank->lcdText;
+            lcdLastInteraction = 0.f;
+            lcdMode = INIT_MODE;
+            lcdStatus.lcdDirty = true;
+        } else {
+            scale.assign(bank->scale);
+            lcdStatus.lcdText1 = bank->lcdText;
             lcdLastInteraction = 0.f;
             lcdMode = INIT_MODE;
             lcdStatus.lcdDirty = true;
@@ -270,39 +511,60 @@ struct Qqqq : Module {
 
     // Returns the last non-empty scene
     int getLastScene() {
-        for (int i = 15; i >=0; i--) {
-            for (int j = 0; j < 12; j++) {
-                if (scale[i][j] == true) return i;
-            }
-        }
-        return 0;
+        return scale.lastNonEmpty();
     }
 
-    // Widget calls this directly
+    // Widget calls this directly. Returns right away, process() picks up the results.
     void importLeadSheet(std::string text){
-        Javascript::Runtime js;
-        js.evaluateString(JavascriptLibraries::TONALJS);
-        js.evaluateString(JavascriptLibraries::TOKENIZE);
-        js.evaluateString(JavascriptLibraries::TOSCALEPOSITION);
-        js.evaluateString(JavascriptLibraries::PARSEASLEADSHEET);
-        js.evaluateString(JavascriptLibraries::LEADSHEETTOQQQQ);
-        js.evaluateString("results = leadsheetToQqqq('" + text + "')");
-        const char* results = js.readVariableAsChar("results");
-        importJson(results);
+        if (tonalJsImport) {
+            importInBackground(importer, "results = leadsheetToQqqq('" + text + "')");
+        } else {
+            publishImport(*importer, bankFromProgression(Chords::leadSheet(text)));
+        }
     }
 
-    // Widget calls this directly
+    // Widget calls this directly. Returns right away, process() picks up the results.
     void importRomanNumeral(std::string text){
-        Javascript::Runtime js;
         std::string tonic = Quantizer::keyLcdName((int) params[KEY_PARAM].getValue());
-        js.evaluateString(JavascriptLibraries::TONALJS);
-        js.evaluateString(JavascriptLibraries::TOKENIZE);
-        js.evaluateString(JavascriptLibraries::TOSCALEPOSITION);
-        js.evaluateString(JavascriptLibraries::PARSEASLEADSHEET);
-        js.evaluateString(JavascriptLibraries::ROMANTOQQQQ);
-        js.evaluateString("results = romanToQqqq('" + tonic + "', '" + text + "')");
-        const char* results = js.readVariableAsChar("results");
-        importJson(results);
+        if (tonalJsImport) {
+            importInBackground(importer, "results = romanToQqqq('" + tonic + "', '" + text + "')");
+        } else {
+            publishImport(*importer, bankFromProgression(Chords::romanNumerals(tonic, text)));
+        }
+    }
+
+    // Widget calls this directly. Takes effect at the next process divider tick, like imports.
+    void loadBank(const SceneBank::Bank& bank) {
+        ImportedBank importedBank;
+        importedBank.scale = bank.scale;
+        importedBank.valid = true;
+        publishImport(*importer, importedBank);
+    }
+
+    // Audio thread. The library never changes under our feet, so there's nothing to wait for.
+    void updateLibraryBank() {
+        if (! libraryCvSelection or scenePolySelection or inputs[SCENE_INPUT].getChannels() < 2) {
+            cvBank = -1;
+            return;
+        }
+        const SceneBank::Library* library = SceneBank::store().get();
+        int banks = library->banks.size();
+        if (banks == 0) return;
+        int bank = clamp((int) rescale(inputs[SCENE_INPUT].getVoltage(1), 0.f, 10.f, 0.f, banks - 0.8f), 0, banks - 1);
+        if (bank == cvBank) return;
+        cvBank = bank;
+        scale.assign(library->banks[bank].scale);
+        scaleToPiano();
+        // At most 11 characters, which std::string keeps inline
+        lcdStatus.lcdText1.assign(library->banks[bank].lcdName);
+        lcdLastInteraction = 0.f;
+        lcdMode = INIT_MODE;
+        lcdStatus.lcdDirty = true;
+    }
+
+    // Only the first channel when the others pick library banks or their own scenes
+    float sceneVoltage() {
+        return (libraryCvSelection or scenePolySelection) ? inputs[SCENE_INPUT].getVoltage(0) : inputs[SCENE_INPUT].getVoltageSum();
     }
 
     // Widget calls this directly
@@ -327,7 +589,7 @@ struct Qqqq : Module {
         lcdStatus.lcdDirty = true;
     }
 
-    // Widget calls this directly
+    // Widget calls this directly. Takes effect at the next process divider tick, like imports.
     void pastePortableSequence(){
         PortableSequence::Sequence sequence;
         sequence.fromClipboard();
@@ -335,13 +597,9 @@ struct Qqqq : Module {
 
         if (sequence.notes.size() < 1) return;
 
-        // Reset scales
-        for (int i = 0; i < 16; i++) {
-            for (int j = 0; j < 12; j++) {
-                scale[i][j] = false;
-            }
-        }
-
+        ImportedBank bank;
+        bank.valid = true;
+        bank.lcdText = "  Pasted!";
         int position = 0;
         for (int i = 0; i < 16; i++) {
             float start = sequence.notes[position].start;
@@ -350,19 +608,13 @@ struct Qqqq : Module {
                 for (size_t j = 0; j < sequence.notes.size(); j++ ) {
                     if (sequence.notes[j].start == start) {
                         int note = (int) (sequence.notes[j].pitch * 12.f + 60.f) % 12;
-                        scale[i][note] = true;
+                        bank.scale[i].set(note);
                         position++;
                     }
                 }
             }
         }
-        scene = 0;
-        params[SCENE_BUTTON_PARAM + 0].setValue(1.f);
-        scaleToPiano();
-        lcdStatus.lcdText1 = "  Pasted!";
-        lcdLastInteraction = 0.f;
-        lcdMode = INIT_MODE;
-        lcdStatus.lcdDirty = true;
+        publishImport(*importer, bank);
     }
 
     void copyScenePortableSequence(int slot){
@@ -385,32 +637,28 @@ struct Qqqq : Module {
         lcdStatus.lcdDirty = true;
     }
 
+    // Same as pastePortableSequence(), for a single scene
     void pasteScenePortableSequence(int slot){
         DEBUG("PASTE %d", slot);
         PortableSequence::Sequence sequence;
         sequence.fromClipboard();
         if (sequence.notes.size() <= 0) return;
-        for (size_t i = 0; i < 12; i++) scale[slot][i] = false;
+        ImportedBank bank;
+        bank.valid = true;
+        bank.slot = slot;
+        bank.lcdText = "  Pasted!";
         for (size_t i = 0; i < sequence.notes.size(); i++){
             int note = (int) (sequence.notes[i].pitch * 12.f + 60.f) % 12;
-            scale[slot][note] = true;
+            bank.scale[slot].set(note);
         }
-        scaleToPiano();
-        lcdStatus.lcdText1 = "  Pasted!";
-        lcdLastInteraction = 0.f;
-        lcdMode = INIT_MODE;
-        lcdStatus.lcdDirty = true;
+        publishImport(*importer, bank);
     }
 
     void updateExpander(){
-        if ((leftExpander.module and leftExpander.module->model == modelQqqq)
-        ||  (leftExpander.module and leftExpander.module->model == modelQuack)
-        ||  (leftExpander.module and leftExpander.module->model == modelQ)
-        ||  (leftExpander.module and leftExpander.module->model == modelQuale)) {
+        if (::Expander::isQuantizer(leftExpander.module)) {
             // We are an expander
             lights[EXPANDER_IN_LIGHT].setBrightness(1.f);
-            bool *message = (bool*) leftExpander.consumerMessage;
-            for (int i = 0; i < 12; i++) receivedExpanderScale[i] = message[i];
+            receivedExpanderScale = ::Expander::receive(this);
             isExpander = true;
         } else {
             // We are not an expander
@@ -418,55 +666,55 @@ struct Qqqq : Module {
             isExpander = false;
         }
 
-        if ((rightExpander.module and rightExpander.module->model == modelQqqq)
-        ||  (rightExpander.module and rightExpander.module->model == modelQuack)
-        ||  (rightExpander.module and rightExpander.module->model == modelQ)
-        ||  (rightExpander.module and rightExpander.module->model == modelQuale)) {
-            // We have an expander
-            lights[EXPANDER_OUT_LIGHT].setBrightness(1.f);
-            bool *message = (bool*) rightExpander.module->leftExpander.producerMessage;			
-            for (int i = 0; i < 12; i++) message[i] = scale[scene][i];
-            rightExpander.module->leftExpander.messageFlipRequested = true;
-        } else {
-            // We have no expander
-            lights[EXPANDER_OUT_LIGHT].setBrightness(0.f);
-        }
-
+        // Whoever is on our right reads our outlet, there's nothing to send
+        lights[EXPANDER_OUT_LIGHT].setBrightness(::Expander::isQuantizer(rightExpander.module) ? 1.f : 0.f);
     }
 
 
-    // Sets the scene. The CV input overrides the buttons.
-    void updateScene() {
+    // Follows the scene input. In audio rate mode this runs every sample, so a new scene
+    // lands on the same sample as the pitch that goes with it. Returns whether the scene moved.
+    bool updateSceneInput() {
+        if (! inputs[SCENE_INPUT].isConnected()) return false;
+        int previousScene = scene;
 
         // Voltage selection
-        if (inputs[SCENE_INPUT].isConnected() && ! sceneTrigSelection && inputs[SCENE_INPUT].getVoltageSum() >= 0.f) {
-            scene = (int) rescale(inputs[SCENE_INPUT].getVoltageSum(), 0.f, 10.f, 0.f, 15.2f);
+        if (! sceneTrigSelection && sceneVoltage() >= 0.f) {
+            scene = sceneOfVoltage(sceneVoltage());
             if (scene != lastScene) sceneChanged = true;
         }
 
         // Trig selection
-        if (inputs[SCENE_INPUT].isConnected() && sceneTrigSelection && sceneSelectionTrigger.process(inputs[SCENE_INPUT].getVoltageSum()) ) {
+        if (sceneTrigSelection && sceneSelectionTrigger.process(sceneVoltage()) ) {
             scene++;
             if (scene > getLastScene()) scene = 0;
             if (scene != lastScene) sceneChanged = true;
         }
 
-        // Button selection
-        if (! inputs[SCENE_INPUT].isConnected()) {
-            for (int i = 0; i < 16; i++) {
-                if ( params[SCENE_BUTTON_PARAM + i].getValue() == 1.f && i != lastScene ) {
+        return scene != previousScene;
+    }
+
+
+    // Sets the scene. The CV input overrides the buttons.
+    void updateScene() {
+
+        updateSceneInput();
+
+        // Button selection. A single pass to read them, they only get written when something is off.
+        bool buttonsOff = (params[SCENE_BUTTON_PARAM + scene].getValue() != 1.f);
+        for (int i = 0; i < 16; i++) {
+            if ( params[SCENE_BUTTON_PARAM + i].getValue() == 1.f && i != lastScene ) {
+                buttonsOff = true;
+                if (! inputs[SCENE_INPUT].isConnected()) {
                     scene = i;
                     sceneChanged = true;
-                    for (int j = 0; j < 16; j++) {
-                        // Turn off the other buttons
-                        if (j != scene) params[SCENE_BUTTON_PARAM + j].setValue(0.f);
-                    }
                 }
             }
         }
 
         // You shouldn't be able to turn on multiple scenes at once, or turn off the current one
-        for (int i = 0; i < 16; i++) params[SCENE_BUTTON_PARAM + i].setValue( (i == scene) ? 1.f : 0.f );
+        if (buttonsOff or scene != lastScene) {
+            for (int i = 0; i < 16; i++) params[SCENE_BUTTON_PARAM + i].setValue( (i == scene) ? 1.f : 0.f );
+        }
 
         lastScene = scene;
     }
@@ -482,7 +730,9 @@ struct Qqqq : Module {
 
     // Update the internal scale to match the state of the piano display
     void pianoToScale() {
-        for (int i = 0; i < 12; i++) scale[scene][i] = (params[NOTE_PARAM + i].getValue() == 1.f)  ? true : false;
+        Quantizer::ScaleMask mask;
+        for (int i = 0; i < 12; i++) mask.set(i, params[NOTE_PARAM + i].getValue() == 1.f);
+        scale.set(scene, mask);
     }
 
 
@@ -496,29 +746,33 @@ struct Qqqq : Module {
 
         // Expander: has it just been connected, or sent something new?
         if (isExpander) {
-            if ((receivedExpanderScale != lastReceivedExpanderScale) || !lastIsExpander) {
-                scale[scene] = receivedExpanderScale;
+            uint64_t generation = receivedExpanderScale.generation;
+            if (generation != 0 and generation != appliedExpanderGeneration) {
+                appliedExpanderGeneration = generation;
+                scale.set(scene, receivedExpanderScale.scale);
                 scaleToPiano();
+                // Not a change of ours, pass it on as it is
+                outlet.forward(receivedExpanderScale, scene);
             }
+        } else {
+            appliedExpanderGeneration = 0;
         }
-        lastIsExpander = isExpander;
-        lastReceivedExpanderScale = receivedExpanderScale;
 
         // External scale: was it just connected?
         if (!lastExtInConnected && inputs[EXT_SCALE_INPUT].isConnected()) {
             for (int i = 0; i < 12; i++){
-                scale[scene][i] = (inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f) ? true : false;
+                scale.setNote(scene, i, inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f);
             }
             scaleToPiano();
         }
 
         // External scale: has it changed?
-        std::array<bool, 12> currentExternalScale;
+        Quantizer::ScaleMask currentExternalScale;
         if (inputs[EXT_SCALE_INPUT].isConnected()) {
-            for (int i = 0; i < 12; i++) currentExternalScale[i] = (inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f) ? true : false;
+            for (int i = 0; i < 12; i++) currentExternalScale.set(i, inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f);
             if (currentExternalScale != lastExternalScale) {
                 lastExternalScale = currentExternalScale;
-                scale[scene] = currentExternalScale;
+                scale.set(scene, currentExternalScale);
                 scaleToPiano();
             }
         }
@@ -526,7 +780,7 @@ struct Qqqq : Module {
 
         // Knobs: have they moved?
         if ( (lastKeyKnob != params[KEY_PARAM].getValue()) || (lastScaleKnob != params[SCALE_PARAM].getValue()) ) {
-            scale[scene] = Quantizer::validNotesInScaleKey(params[SCALE_PARAM].getValue(), params[KEY_PARAM].getValue());
+            scale.set(scene, Quantizer::validNotesInScaleKey(params[SCALE_PARAM].getValue(), params[KEY_PARAM].getValue()));
             scaleToPiano();
         }
         lastKeyKnob = params[KEY_PARAM].getValue();
@@ -538,21 +792,28 @@ struct Qqqq : Module {
 
 
     void updateExternalOutput() {
-        if (outputs[EXT_SCALE_OUTPUT].isConnected()){
-            for (int i = 0; i < 12; i++) {
-                if (scale[scene][i]) {
-                    if ((int) params[KEY_PARAM].getValue() == i) {
-                        outputs[EXT_SCALE_OUTPUT].setVoltage(10.f, i);
-                    } else {
-                        outputs[EXT_SCALE_OUTPUT].setVoltage(8.f, i);
-                    }
+        if (! outputs[EXT_SCALE_OUTPUT].isConnected()) {
+            // Write it all again once it's connected
+            lastOutputKey = -1;
+            return;
+        }
+        int key = (int) params[KEY_PARAM].getValue();
+        if (scale[scene] == lastOutputScale && key == lastOutputKey) return;
+        lastOutputScale = scale[scene];
+        lastOutputKey = key;
+        for (int i = 0; i < 12; i++) {
+            if (scale[scene][i]) {
+                if (key == i) {
+                    outputs[EXT_SCALE_OUTPUT].setVoltage(10.f, i);
                 } else {
-                    outputs[EXT_SCALE_OUTPUT].setVoltage(0.f, i);
+                    outputs[EXT_SCALE_OUTPUT].setVoltage(8.f, i);
                 }
-            } 
-            // outputs[EXT_SCALE_OUTPUT].setVoltage( (scale[scene][i]) ? 8.f : 0.f, i);
-            outputs[EXT_SCALE_OUTPUT].setChannels(12);
-        }
+            } else {
+                outputs[EXT_SCALE_OUTPUT].setVoltage(0.f, i);
+            }
+        } 
+        // outputs[EXT_SCALE_OUTPUT].setVoltage( (scale[scene][i]) ? 8.f : 0.f, i);
+        outputs[EXT_SCALE_OUTPUT].setChannels(12);
     }
 
 
@@ -578,17 +839,70 @@ struct Qqqq : Module {
     }
 
 
-    void processQuantizerColumn(int col){
+    // The quantizer of a scene, rebuilt first if the scene changed since
+    const Quantizer::Engine* quantizerOf(int scene) {
+        if (scale.dirty & (1 << scene)) {
+            scale.dirty &= ~(1 << scene);
+            quantizers[scene].setScale(scale[scene]);
+        }
+        return &quantizers[scene];
+    }
+
+
+    // Everything goes through the current scene's quantizer, unless each channel of the scene input picks its own.
+    // Then it's one lookup per channel, and that's sample accurate in audio rate mode.
+    void updateChannelQuantizers() {
+        if (! perChannelScenes) {
+            channelQuantizers[0] = quantizerOf(scene);
+            return;
+        }
+        for (int c = 0; c < 16; c++) {
+            channelQuantizers[c] = quantizerOf(sceneOfVoltage(inputs[SCENE_INPUT].getPolyVoltage(c)));
+        }
+    }
+
+
+    // Reads the column knobs and switches, once per process divider tick
+    void updateColumns() {
+        perChannelScenes = scenePolySelection and inputs[SCENE_INPUT].isConnected();
+        for (int col = 0; col < 4; col++) {
+            Column& column = columns[col];
+            column.outputConnected = outputs[CV_OUTPUT + col].isConnected();
+            column.visualize = (params[VISUALIZE_PARAM + col].getValue() == 1.f);
+            column.shConnected = inputs[SH_INPUT + col].isConnected();
+            column.trackAndHold = (params[SH_MODE_PARAM].getValue() != 0.f);
+            float scaling = params[SCALING_PARAM + col].getValue();
+            float offset = params[OFFSET_PARAM + col].getValue();
+            float transpose = params[TRANSPOSE_PARAM + col].getValue();
+            float transposeMode = params[TRANSPOSE_MODE_PARAM + col].getValue();
+            if (scaling == column.scaling && offset == column.offset
+            &&  transpose == column.transpose && transposeMode == column.transposeMode
+            &&  perChannelScenes == column.perChannel) continue;
+            column.scaling = scaling;
+            column.offset = offset;
+            column.transpose = transpose;
+            column.transposeMode = transposeMode;
+            column.perChannel = perChannelScenes;
+            column.compile();
+        }
+    }
+
+
+    // Lights up the piano only at process divider ticks, it's not going to be seen any faster.
+    void processQuantizerColumn(int col, bool control){
+        PROFILE_SCOPE(profile, PROFILE_QUANTIZER_COLUMN);
+        const Column& column = columns[col];
+        bool visualize = control && column.visualize;
         std::array<float, 16> voltage = inputVoltage[col];
         int channels = inputChannels[col];
         bool sh = false;
         
         // Stop if no output while visualization is not enabled
-        if (! outputs[CV_OUTPUT + col].isConnected() && params[VISUALIZE_PARAM + col].getValue() == 0.f ) return;
+        if (! column.outputConnected && ! visualize) return;
 
         // S&H
-        if (inputs[SH_INPUT + col].isConnected()){
-            if (params[SH_MODE_PARAM].getValue() == 0.f) {
+        if (column.shConnected){
+            if (! column.trackAndHold) {
                 // S&H mode
                 if (shTrigger[col].process(inputs[SH_INPUT + col].getVoltageSum())) sh = true;
             } else {
@@ -600,53 +914,28 @@ struct Qqqq : Module {
             sh = true;
         }
 
-        if (sh) shChannels[col] = channels;
-
-        // Iterate channels
-        for (int i = 0; i < channels; i++) {
-
-            // Only process if S&H this sample
-            if (sh) {
-                // Scale and offset
-                voltage[i] = voltage[i] * params[SCALING_PARAM + col].getValue() / 100.f;
-                voltage[i] = voltage[i] + params[OFFSET_PARAM + col].getValue();
-                if (params[TRANSPOSE_MODE_PARAM + col].getValue() == 0.f) {
-                    // Quantize in transpose mode 0: Octaves
-                    voltage[i] = Quantizer::quantize(clamp(voltage[i], -5.f, 5.f), scale[scene]);
-                    for (size_t j = 0; j < abs((int) params[TRANSPOSE_PARAM + col].getValue()); j++ ) {
-                        if (params[TRANSPOSE_PARAM + col].getValue() > 0.f && voltage[i] <= 5.f) {
-                            voltage[i] += 1.f;
-                        }
-                        if (params[TRANSPOSE_PARAM + col].getValue() < 0.f && voltage[i] >= -5.f) {
-                            voltage[i] -= 1.f;
-                        }
-                    }
-                }
-                if (params[TRANSPOSE_MODE_PARAM + col].getValue() == 1.f) {
-                    // Quantize in transpose mode 1: Semitones
-                    voltage[i] = voltage[i] + params[TRANSPOSE_PARAM + col].getValue() * 1.f / 12.f;
-                    voltage[i] = Quantizer::quantize(clamp(voltage[i], -5.f, 5.f), scale[scene]);
-                }
-                if (params[TRANSPOSE_MODE_PARAM + col].getValue() == 2.f) {
-                    // Quantize in transpose mode 2: Scale degrees
-                    voltage[i] = Quantizer::quantize(clamp(voltage[i], -5.f, 5.f), scale[scene], (int) params[TRANSPOSE_PARAM + col].getValue());
-                }
-                shVoltage[col][i] = voltage[i];
-            } else {
-                // No S&H
-                voltage[i] = shVoltage[col][i];
-            }
+        if (sh) {
+            shChannels[col] = channels;
+            column.function(column, channelQuantizers.data(), voltage.data(), channels);
+            shVoltage[col] = voltage;
+        } else {
+            // No S&H
+            voltage = shVoltage[col];
+        }
 
-            // Piano display
-            if (params[VISUALIZE_PARAM + col].getValue() == 1.f) {
+        // Piano display
+        if (visualize) {
+            for (int i = 0; i < channels; i++) {
                  // Must be positive to work. The 0.01f is to fudge float math in transpose mode 2.
                 float v = voltage[i] * 12.f + 60.01f;
                 int n = (int) v % 12;
                 litKeys[n] = true;
             }
+        }
 
-            // Output!
-            outputs[CV_OUTPUT + col].setVoltage(voltage[i], i);
+        // Output!
+        for (int c = 0; c < channels; c += 4) {
+            outputs[CV_OUTPUT + col].setVoltageSimd(simd::float_4::load(voltage.data() + c), c);
         }
 
         outputs[CV_OUTPUT + col].setChannels( (sh) ? channels : shChannels[col]);
@@ -654,6 +943,7 @@ struct Qqqq : Module {
 
 
     void updateLcd(const ProcessArgs& args){
+        PROFILE_SCOPE(profile, PROFILE_UPDATE_LCD);
         std::string text;
 
         // Reset after 3 seconds since the last interactive input was touched
@@ -736,20 +1026,39 @@ struct Qqqq : Module {
 
 
     void process(const ProcessArgs& args) override {
-        if (processDivider.process()) {
+        PROFILE_SCOPE(profile, PROFILE_PROCESS);
+        // Everything that can change from the UI or the expander is only looked at on ticks.
+        // Between them, in audio rate mode, only the scene input can change what we quantize to.
+        bool control = processDivider.process();
+        if (control) {
+            applyImport();
+            updateLibraryBank();
             updateExpander();
             updateScene();
             updateScale();
+            updateColumns();
+            updateChannelQuantizers();
+            outlet.publish(scale[scene], scene);
             cleanLitKeys();
+        } else if (audioRate) {
+            if (updateSceneInput()) {
+                if (! perChannelScenes) updateChannelQuantizers();
+                outlet.publish(scale[scene], scene);
+            }
+            if (perChannelScenes) updateChannelQuantizers();
+        }
+        if (control or audioRate) {
             processInputs();
-            for(int i = 0; i < 4; i++) processQuantizerColumn(i);
+            for(int i = 0; i < 4; i++) processQuantizerColumn(i, control);
             updateExternalOutput();
         }
+        if (control) {
+            // Fixes MIDI-MAP turning off buttons
+            params[SCENE_BUTTON_PARAM + scene].setValue(1.f);
+        }
         if (lcdDivider.process()) {
             updateLcd(args);
         }
-        // Fixes MIDI-MAP turning off buttons
-        params[SCENE_BUTTON_PARAM + scene].setValue(1.f);
     }
 
 };
@@ -961,6 +1270,67 @@ struct PastePortableSequenceItem : MenuItem {
     }
 };
 
+// Scene bank library, shared by all three widgets
+struct LibraryBankItem : MenuItem {
+    Qqqq *module;
+    SceneBank::Bank bank;
+    void onAction(const event::Action &e) override {
+        module->loadBank(bank);
+    }
+};
+
+struct ImportLibraryItem : MenuItem {
+    void onAction(const event::Action &e) override {
+        osdialog_filters* filters = osdialog_filters_parse("Progressions (.txt .json):txt,json");
+        char* path = osdialog_file(OSDIALOG_OPEN, asset::user("").c_str(), NULL, filters);
+        osdialog_filters_free(filters);
+        if (! path) return;
+        SceneBank::store().importFileInBackground(path);
+        free(path);
+    }
+};
+
+struct LibraryMenuItem : MenuItem {
+    Qqqq *module;
+    Menu *createChildMenu() override {
+        Menu *menu = new Menu;
+        menu->addChild(createMenuItem<ImportLibraryItem>("Import progressions from a file..."));
+        if (SceneBank::store().importing > 0) menu->addChild(createMenuLabel("Importing..."));
+        const SceneBank::Library* library = SceneBank::store().get();
+        if (! library->banks.empty()) menu->addChild(new MenuSeparator());
+        for (const SceneBank::Bank& bank : library->banks) {
+            LibraryBankItem *item = createMenuItem<LibraryBankItem>(bank.name);
+            item->module = module;
+            item->bank = bank;
+            menu->addChild(item);
+        }
+        return menu;
+    }
+};
+
+inline void appendLibraryMenu(ui::Menu *menu, Qqqq *module) {
+    menu->addChild(new MenuSeparator());
+    LibraryMenuItem *libraryMenuItem = createMenuItem<LibraryMenuItem>("Scene bank library");
+    libraryMenuItem->module = module;
+    libraryMenuItem->rightText = RIGHT_ARROW;
+    menu->addChild(libraryMenuItem);
+}
+
+struct AudioRateItem : MenuItem {
+    Qqqq *module;
+    void onAction(const event::Action &e) override {
+        module->audioRate = ! module->audioRate;
+    }
+};
+
+inline void appendAudioRateItem(ui::Menu *menu, Qqqq *module) {
+    menu->addChild(new MenuSeparator());
+    AudioRateItem *audioRateItem = createMenuItem<AudioRateItem>("Quantize at audio rate (more CPU)");
+    audioRateItem->module = module;
+    audioRateItem->rightText += (module->audioRate) ? "✔" : "";
+    menu->addChild(audioRateItem);
+}
+
 struct PushButtonKeyboard : SvgSwitchUnshadowed {
     PushButtonKeyboard() {
         addFrame(APP->window->loadSvg(asset::plugin(pluginInstance, "res/components/button-keyboard.svg")));
@@ -1251,6 +1621,7 @@ struct QqqqWidget : ModuleWidget {
         Qqqq *module;
         void onAction(const event::Action &e) override {
             module->sceneTrigSelection = false;
+            module->scenePolySelection = false;
         }
     };
 
@@ -1258,6 +1629,29 @@ struct QqqqWidget : ModuleWidget {
         Qqqq *module;
         void onAction(const event::Action &e) override {
             module->sceneTrigSelection = true;
+            module->scenePolySelection = false;
+        }
+    };
+
+    struct ScenePolySelectionConfigItem : MenuItem {
+        Qqqq *module;
+        void onAction(const event::Action &e) override {
+            module->sceneTrigSelection = false;
+            module->scenePolySelection = true;
+        }
+    };
+
+    struct LibraryCvSelectionItem : MenuItem {
+        Qqqq *module;
+        void onAction(const event::Action &e) override {
+            module->libraryCvSelection = ! module->libraryCvSelection;
+        }
+    };
+
+    struct TonalJsImportItem : MenuItem {
+        Qqqq *module;
+        void onAction(const event::Action &e) override {
+            module->tonalJsImport = ! module->tonalJsImport;
         }
     };
 
@@ -1270,13 +1664,36 @@ struct QqqqWidget : ModuleWidget {
 
         SceneStandardSelectionConfigItem *sceneStandardSelectionConfigItem = createMenuItem<SceneStandardSelectionConfigItem>("Select Scenes with 0V~10V");
         sceneStandardSelectionConfigItem->module = module;
-        sceneStandardSelectionConfigItem->rightText += (module->sceneTrigSelection) ? "" : "✔";
+        sceneStandardSelectionConfigItem->rightText += (module->sceneTrigSelection or module->scenePolySelection) ? "" : "✔";
         menu->addChild(sceneStandardSelectionConfigItem);
 
         SceneTrigSelectionConfigItem *sceneTrigSelectionConfigItem = createMenuItem<SceneTrigSelectionConfigItem>("Advance Scenes with trigs");
         sceneTrigSelectionConfigItem->module = module;
         sceneTrigSelectionConfigItem->rightText += (module->sceneTrigSelection) ? "✔" : "";
         menu->addChild(sceneTrigSelectionConfigItem);
+
+        ScenePolySelectionConfigItem *scenePolySelectionConfigItem = createMenuItem<ScenePolySelectionConfigItem>("Select a Scene for each channel (poly)");
+        scenePolySelectionConfigItem->module = module;
+        scenePolySelectionConfigItem->rightText += (module->scenePolySelection) ? "✔" : "";
+        menu->addChild(scenePolySelectionConfigItem);
+
+        menu->addChild(new MenuSeparator());
+
+        TonalJsImportItem *tonalJsImportItem = createMenuItem<TonalJsImportItem>("Parse imported chords with Tonal.js (slower)");
+        tonalJsImportItem->module = module;
+        tonalJsImportItem->rightText += (module->tonalJsImport) ? "✔" : "";
+        menu->addChild(tonalJsImportItem);
+
+        QqqqWidgets::appendLibraryMenu(menu, module);
+
+        LibraryCvSelectionItem *libraryCvSelectionItem = createMenuItem<LibraryCvSelectionItem>("Select banks with channel 2 of the scene input");
+        libraryCvSelectionItem->module = module;
+        libraryCvSelectionItem->rightText += (module->libraryCvSelection) ? "✔" : "";
+        menu->addChild(libraryCvSelectionItem);
+
+        QqqqWidgets::appendAudioRateItem(menu, module);
+
+        Profiler::appendContextMenu(menu, module, module->profile);
     }
 
 
@@ -1354,6 +1771,14 @@ struct QuackWidget : ModuleWidget {
         addChild(createLight<SmallLight<InputLight>>(mm2px(Vec(1.4, 125.2)), module, Qqqq::EXPANDER_IN_LIGHT));
         addChild(createLight<SmallLight<OutputLight>>(mm2px(Vec(32.06, 125.2)), module, Qqqq::EXPANDER_OUT_LIGHT));
     }
+
+    void appendContextMenu(ui::Menu *menu) override {
+        Qqqq *module = dynamic_cast<Qqqq*>(this->module);
+        assert(module);
+        QqqqWidgets::appendLibraryMenu(menu, module);
+        QqqqWidgets::appendAudioRateItem(menu, module);
+        Profiler::appendContextMenu(menu, module, module->profile);
+    }
 };
 
 
@@ -1408,6 +1833,14 @@ struct QWidget : ModuleWidget {
         addChild(createLight<SmallLight<InputLight>>(mm2px(Vec(1.4, 125.2)), module, Qqqq::EXPANDER_IN_LIGHT));
         addChild(createLight<SmallLight<OutputLight>>(mm2px(Vec(11.74, 125.2)), module, Qqqq::EXPANDER_OUT_LIGHT));
     }
+
+    void appendContextMenu(ui::Menu *menu) override {
+        Qqqq *module = dynamic_cast<Qqqq*>(this->module);
+        assert(module);
+        QqqqWidgets::appendLibraryMenu(menu, module);
+        QqqqWidgets::appendAudioRateItem(menu, module);
+        Profiler::appendContextMenu(menu, module, module->profile);
+    }
 };
 
 } // namespace Qqqq
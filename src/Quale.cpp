@@ -8,6 +8,8 @@ You should have received a copy of the GNU General Public License along with thi
 
 #include "plugin.hpp"
 #include "quantizer.hpp"
+#include "scheduler.hpp"
+#include "expander.hpp"
 
 namespace Quale {
 
@@ -34,36 +36,43 @@ struct Quale : Module {
         NUM_LIGHTS
     };
 
-    bool leftMessages[2][12];
-    std::array<bool, 12> scale;
-    dsp::ClockDivider processDivider;
+    // What we show the module on our right. The chain starts over with us, we don't pass on what we receive.
+    ::Expander::ScaleOutlet outlet;
+    Quantizer::ScaleMask scale;
+    // What the chord output shows when we're an expander, 0 when it needs writing again
+    uint64_t chordGeneration = 0;
+    Scheduler::Divider processDivider;
     
     Quale() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         processDivider.setDivision(PROCESSDIVIDER);
-        leftExpander.producerMessage = leftMessages[0];
-        leftExpander.consumerMessage = leftMessages[1];
+        outlet.relays = false;
+        rightExpander.producerMessage = &outlet;
     }
 
     void processScaleToChord() {
         size_t j = 0;
 
         // If we are an expander, the input jack is not used.
-        if ((leftExpander.module and leftExpander.module->model == modelQqqq)
-        ||  (leftExpander.module and leftExpander.module->model == modelQuack)
-        ||  (leftExpander.module and leftExpander.module->model == modelQ)) {
+        // Quale can't be chained after another Quale, it wouldn't make sense.
+        if (leftExpander.module and leftExpander.module->model != modelQuale and ::Expander::isQuantizer(leftExpander.module)) {
             // We are an expander
             lights[EXPANDER_IN_LIGHT].setBrightness(1.f);
             lights[SCALE_TO_CHORD_LIGHT].setBrightness(0.f);
-            bool *message = (bool*) leftExpander.consumerMessage;
-            if (outputs[CHORD_OUTPUT].isConnected()) {
+            ::Expander::ScaleMessage message = ::Expander::receive(this);
+            // Nothing to do until the scale changes
+            if (! outputs[CHORD_OUTPUT].isConnected()) {
+                chordGeneration = 0;
+            } else if (message.generation != chordGeneration) {
+                chordGeneration = message.generation;
                 for (size_t i = 0; i < 12; i++) {
-                    if (message[i]) outputs[CHORD_OUTPUT].setVoltage((i * 1.f/12.f) , j++);
+                    if (message.scale[i]) outputs[CHORD_OUTPUT].setVoltage((i * 1.f/12.f) , j++);
                 }
                 outputs[CHORD_OUTPUT].setChannels(j);
             }
         } else {
             // We are not an expander
+            chordGeneration = 0;
             lights[EXPANDER_IN_LIGHT].setBrightness(0.f);
             lights[SCALE_TO_CHORD_LIGHT].setBrightness(1.f);
             if (outputs[CHORD_OUTPUT].isConnected()){
@@ -77,25 +86,17 @@ struct Quale : Module {
 
     void processChordToScale() {
         // Whether we have an expander or not, the input comes from the jack
-        for (size_t i = 0; i < 12; i++) scale[i] = false;
+        scale = Quantizer::ScaleMask();
         if (inputs[CHORD_INPUT].isConnected()) {
             for (int i = 0; i < inputs[CHORD_INPUT].getChannels(); i++) {
-                scale[Quantizer::quantizeToPositionInOctave(inputs[CHORD_INPUT].getVoltage(i), Quantizer::validNotesInScale(Quantizer::CHROMATIC))] = true;
+                scale.set(Quantizer::quantizeToPositionInOctave(inputs[CHORD_INPUT].getVoltage(i), Quantizer::validNotesInScale(Quantizer::CHROMATIC)));
             }
         }
 
-        if ((rightExpander.module and rightExpander.module->model == modelQqqq)
-        ||  (rightExpander.module and rightExpander.module->model == modelQuack)
-        ||  (rightExpander.module and rightExpander.module->model == modelQ)) {
-            // We have an expander
-            lights[EXPANDER_OUT_LIGHT].setBrightness(1.f);
-            bool *message = (bool*) rightExpander.module->leftExpander.producerMessage;			
-            for (size_t i = 0; i < 12; i++) message[i] = scale[i];
-            rightExpander.module->leftExpander.messageFlipRequested = true;
-        } else {
-            // We have no expander
-            lights[EXPANDER_OUT_LIGHT].setBrightness(0.f);
-        }
+        // Whoever is on our right reads it from there
+        outlet.publish(scale, 0);
+        bool hasExpander = rightExpander.module and rightExpander.module->model != modelQuale and ::Expander::isQuantizer(rightExpander.module);
+        lights[EXPANDER_OUT_LIGHT].setBrightness(hasExpander ? 1.f : 0.f);
 
         if (outputs[SCALE_OUTPUT].isConnected()){
             for (size_t i = 0; i < 12; i++) outputs[SCALE_OUTPUT].setVoltage( (scale[i]) ? 10.f : 0.f, i);
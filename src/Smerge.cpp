@@ -4,6 +4,7 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
 
 namespace Smerge{
 
@@ -28,25 +29,38 @@ struct Smerge : Module {
         NUM_LIGHTS
     };
     
-    dsp::ClockDivider ledDivider;
+    Scheduler::Divider ledDivider;
+    Scheduler::Divider connectionDivider;
+
+    // Cables and the switch don't move at audio rate, so they're only checked every few samples.
+    // The voltages themselves are still copied every sample.
+    bool sort = false;
+    bool linkConnected = false;
+    std::array<bool, 16> mergeConnected {};
+    int lastMergeChannel = 0;
 
     Smerge() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         ledDivider.setDivision(256);
+        connectionDivider.setDivision(32);
         configParam(SORT_PARAM, 0.f, 1.f, 0.f, "Sort voltages");
+        updateConnections();
+    }
+
+    void updateConnections() {
+        sort = params[SORT_PARAM].getValue();
+        linkConnected = inputs[LINK_INPUT].isConnected();
+        lastMergeChannel = 0;
+        for (int i = 0; i < 16; i++) {
+            mergeConnected[i] = inputs[MERGE_INPUT + i].isConnected();
+            if (mergeConnected[i]) lastMergeChannel = i + 1;
+        }
     }
     
     // Merge without sorting, faster
     void merge(const ProcessArgs& args) {
-        int lastMergeChannel = 0;
-        for (int i = 0; i < 16; i++) {
-            if (inputs[MERGE_INPUT + i].isConnected()) {
-                outputs[POLY_OUTPUT].setVoltage(inputs[MERGE_INPUT + i].getVoltage(), i);
-                lastMergeChannel = i+1;
-            } else {
-                outputs[POLY_OUTPUT].setVoltage(0, i);
-            }
-        }
+        for (int i = 0; i < lastMergeChannel; i++)
+            outputs[POLY_OUTPUT].setVoltage( (mergeConnected[i]) ? inputs[MERGE_INPUT + i].getVoltage() : 0.f, i);
         outputs[POLY_OUTPUT].setChannels(lastMergeChannel);
     }
     
@@ -55,7 +69,7 @@ struct Smerge : Module {
         std::array<std::array<float, 2>, 16> mergedVoltages;	
         int connected = 0;
         
-        if (inputs[LINK_INPUT].isConnected()) {
+        if (linkConnected) {
             // Link input
             bool lastFound = false;
             for (int i = 15; i >= 0; i--) {
@@ -74,7 +88,7 @@ struct Smerge : Module {
         } else {
             // No link input
             for (int i = 0; i < 16; i++) {
-                if (inputs[MERGE_INPUT + i].isConnected()) {
+                if (mergeConnected[i]) {
                     mergedVoltages[i][0] = inputs[MERGE_INPUT + i].getVoltage();
                     mergedVoltages[i][1] = (i + 1.f) * 0.1f;
                     connected = i + 1;
@@ -93,7 +107,7 @@ struct Smerge : Module {
         outputs[POLY_OUTPUT].setChannels(connected);
         
         // Send to link output
-        if (! inputs[LINK_INPUT].isConnected()) {
+        if (! linkConnected) {
             outputs[LINK_OUTPUT].setChannels(connected);
             for (int i = 0; i < 16; i++) {
                 outputs[LINK_OUTPUT].setVoltage(mergedVoltages[i][1], i);
@@ -102,13 +116,13 @@ struct Smerge : Module {
     }
     
     void chainLink(const ProcessArgs& args) {
-        if (inputs[LINK_INPUT].isConnected()) {
+        if (linkConnected) {
             outputs[LINK_OUTPUT].setChannels(inputs[LINK_INPUT].getChannels());
             for (int i = 0; i < 16; i++) {
                 outputs[LINK_OUTPUT].setVoltage(inputs[LINK_INPUT].getVoltage(i), i);
             }
         } else {
-            if (! params[SORT_PARAM].getValue()) {
+            if (! sort) {
                 outputs[LINK_OUTPUT].setChannels(0);
             }
         }
@@ -116,7 +130,7 @@ struct Smerge : Module {
     
     
     void updateLeds(const ProcessArgs& args) {
-        if ( (params[SORT_PARAM].getValue()) or (inputs[LINK_INPUT].isConnected()) ) {
+        if (sort or linkConnected) {
             lights[LINK_IN_LIGHT].setBrightness(1.f);
             lights[LINK_OUT_LIGHT].setBrightness(1.f);
         } else {
@@ -127,7 +141,9 @@ struct Smerge : Module {
 
 
     void process(const ProcessArgs& args) override {
-        (params[SORT_PARAM].getValue()) ? mergeSortLink(args) : merge(args);
+        if (connectionDivider.process())
+            updateConnections();
+        (sort) ? mergeSortLink(args) : merge(args);
         chainLink(args); // Chain link inputs, whether sorting or not
         if (ledDivider.process())
             updateLeds(args);
@@ -11,7 +11,11 @@ You should have received a copy of the GNU General Public License along with thi
 #include "lcd.hpp"
 #include "quantizer.hpp"
 #include "prng.hpp"
+#include "steps.hpp"
 #include "portablesequence.hpp"
+#include "profiler.hpp"
+#include "scheduler.hpp"
+#include <bitset>
 
 namespace Solomon {
 
@@ -37,6 +41,7 @@ enum LcdModes {
 
 template <size_t NODES>
 struct Solomon : Module {
+    static_assert(NODES <= 32, "Picking from the queue uses 32 bit masks");
     enum ParamIds {
         KEY_PARAM,
         SCALE_PARAM,
@@ -105,7 +110,7 @@ struct Solomon : Module {
     float slideDuration = 0.f;
     float slideCounter = 0.f;
     float lastOutput = 0.f;
-    std::array<bool, 12> scale;
+    Quantizer::ScaleMask scale;
     dsp::SchmittTrigger stepQueueTrigger;
     dsp::SchmittTrigger stepTeleportTrigger;
     dsp::SchmittTrigger stepWalkTrigger;
@@ -116,15 +121,17 @@ struct Solomon : Module {
     dsp::SchmittTrigger resetTrigger;
     dsp::PulseGenerator globalTrigger;
     dsp::PulseGenerator globalDisplayTrigger;
-    dsp::ClockDivider outputDivider;
+    Scheduler::Divider outputDivider;
     prng::prng prng;
     Lcd::LcdStatus lcdStatus;
+    enum ProfileIds { PROFILE_PROCESS, PROFILE_SEND_OUTPUTS, NUM_PROFILES };
+    Profiler::Profile profile {"process", "sendOutputs"};
 
     // Per node
     float cv[NODES];
     float savedCv[NODES];
-    std::array<bool, NODES> queue;
-    std::array<bool, NODES> windowQueue;
+    std::bitset<NODES> queue;
+    std::bitset<NODES> windowQueue;
     std::array<bool, NODES> delay;
     std::array<bool, NODES> sub1Sd;
     std::array<bool, NODES> sub2Sd;
@@ -173,7 +180,7 @@ struct Solomon : Module {
         lcdStatus.lcdText2 = "SUMMONING..";
         lcdStatus.lcdLastInteraction = 0.f;
 
-        prng.init(random::uniform(), random::uniform());
+        prng.seed(random::u64());
     }
 
     void onReset() override {
@@ -260,7 +267,7 @@ struct Solomon : Module {
         if (scaleJ) {
             for (size_t i = 0; i < 12; i++) {
                 json_t *scaleNoteJ = json_array_get(scaleJ, i);
-                if (scaleNoteJ) scale[i] = json_boolean_value(scaleNoteJ);
+                if (scaleNoteJ) scale.set(i, json_boolean_value(scaleNoteJ));
             }
         }
 
@@ -348,7 +355,7 @@ struct Solomon : Module {
 
     void updateScale() {
         if (inputs[EXT_SCALE_INPUT].isConnected() ) {
-            for (size_t i = 0; i < 12; i++) scale[i] = (inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f) ? true : false;
+            for (size_t i = 0; i < 12; i++) scale.set(i, inputs[EXT_SCALE_INPUT].getVoltage(i) > 0.1f);
         } else {
             scale = Quantizer::validNotesInScaleKey( (int) params[SCALE_PARAM].getValue(), (int) params[KEY_PARAM].getValue());
         }
@@ -370,13 +377,14 @@ struct Solomon : Module {
         return (size_t) params[TOTAL_NODES_PARAM].getValue();
     }
 
+    // Bits for the nodes set by the knob
+    uint32_t totalNodesMask() {
+        return Steps::mask(getTotalNodes());
+    }
+
     // How many nodes are enqueued
     size_t queueCount() {
-        size_t count = 0;
-        for(size_t i = 0; i < getTotalNodes(); i++) {
-            if (queue[i] == true) count++;
-        }
-        return count;
+        return __builtin_popcount(queue.to_ulong() & totalNodesMask());
     }
 
     // It's safe for users to swap Min and Max. Clamped to avoid C10 breaking the display.
@@ -516,11 +524,11 @@ struct Solomon : Module {
     }
 
     void clearQueue() {
-        for(size_t i = 0; i < NODES; i++) queue[i] = false;
+        queue.reset();
     }
 
     void clearWindowQueue() {
-        for(size_t i = 0; i < NODES; i++) windowQueue[i] = false;
+        windowQueue.reset();
     }
 
     void clearDelay() {
@@ -545,12 +553,7 @@ struct Solomon : Module {
 
         // Only select from the queue if we know we have something in it, or we crash.
         if (stepType == STEP_QUEUE) {
-            std::vector<size_t> validSteps;
-            for (size_t i = 0; i < getTotalNodes(); i++) {
-                if (queue[i]) validSteps.push_back(i);
-            }
-            std::random_shuffle(validSteps.begin(), validSteps.end());
-            selectedQueueNode = validSteps[0];
+            selectedQueueNode = Steps::dequeue(prng, queue.to_ulong() & totalNodesMask());
             queue[selectedQueueNode] = false;
         }
         
@@ -558,9 +561,7 @@ struct Solomon : Module {
         if (params[QUEUE_CLEAR_MODE_PARAM].getValue() == 1.f) clearQueue();
 
         // Add window queue triggers no matter the configuration        
-        for (size_t i = 0; i < NODES; i++) {
-            if (!queue[i]) queue[i] = windowQueue[i];
-        }
+        queue |= windowQueue;
         clearWindowQueue();
     }
 
@@ -616,66 +617,12 @@ struct Solomon : Module {
             currentNode = selectedQueueNode;
         }
 
-        // Teleport never brings back to the current step - unless we only have one,
-        // or are in Repeat mode.
-        if (stepType == STEP_TELEPORT) {
-            if (getTotalNodes() > 1) {
-                std::vector<size_t> validNodes;
-                for (size_t i = 0; i < getTotalNodes(); i++) {
-                    if (params[REPEAT_MODE_PARAM].getValue() == 0.f) {
-                        if (i != currentNode) validNodes.push_back(i);
-                    } else {
-                        validNodes.push_back(i);
-                    }
-                }
-                std::random_shuffle(validNodes.begin(), validNodes.end());
-                currentNode = validNodes[0];
-            } else {
-                currentNode = 0;
-            }
-        }
-
-        // Random walk can warp around
-        if (stepType == STEP_WALK) {
-            if (params[REPEAT_MODE_PARAM].getValue() == 1.f && prng.uniform() < 1.f / 3.f) {
-                // 1 chance out of 3 the current node repeats
-            } else {
-                // Then it's a coin flip which direction we go
-                if (prng.uniform() >= 0.5f) {
-                    // Walk forward
-                    if (currentNode >= getTotalNodes() - 1) {
-                        currentNode = 0;
-                    } else {
-                        currentNode++;
-                    }
-                } else {
-                    // Walk back
-                    if (currentNode == 0) {
-                        currentNode = getTotalNodes() - 1;
-                    } else {
-                        currentNode--;
-                    }
-                }
-            }
-        }
-
-        // Step back can warp around
-        if (stepType == STEP_BACK) {
-            if (currentNode == 0) {
-                currentNode = getTotalNodes() - 1;
-            } else {
-                currentNode--;
-            }
-        }
-
-        // Step forward can warp around
-        if (stepType == STEP_FORWARD) {
-            if (currentNode >= getTotalNodes() - 1) {
-                currentNode = 0;
-            } else {
-                currentNode++;
-            }
-        }
+        // See steps.hpp for how each of them moves
+        bool repeat = (params[REPEAT_MODE_PARAM].getValue() == 1.f);
+        if (stepType == STEP_TELEPORT) currentNode = Steps::teleport(prng, currentNode, getTotalNodes(), repeat);
+        if (stepType == STEP_WALK) currentNode = Steps::walk(prng, currentNode, getTotalNodes(), repeat);
+        if (stepType == STEP_BACK) currentNode = Steps::back(currentNode, getTotalNodes());
+        if (stepType == STEP_FORWARD) currentNode = Steps::forward(currentNode, getTotalNodes());
     }
 
     void updateLatch() {
@@ -705,6 +652,7 @@ struct Solomon : Module {
 
     // We refresh lotsa stuff, but we don't need to do it at audio rates
     void sendOutputs(const ProcessArgs& args) {
+        PROFILE_SCOPE(profile, PROFILE_SEND_OUTPUTS);
         outputs[GLOBAL_TRIG_OUTPUT].setVoltage( globalTrigger.process(args.sampleTime) ? 10.f : 0.f);
         globalDisplayTrigger.process(args.sampleTime);
 
@@ -734,6 +682,7 @@ struct Solomon : Module {
     }
 
     void process(const ProcessArgs& args) override {
+        PROFILE_SCOPE(profile, PROFILE_PROCESS);
 
         lcdStatus.notificationStep(args.sampleTime);
 
@@ -834,7 +783,7 @@ struct ScaleKnob : AriaKnob820 {
             text = "EXTERNAL";
         }
         module->lcdStatus.lcdText2 = text;
-        module->lcdStatus.pianoDisplay = module->scale;
+        module->lcdStatus.pianoDisplay = module->scale.toArray();
 
         AriaKnob820::onDragMove(e);
     }
@@ -1276,6 +1225,8 @@ struct SolomonWidget8 : ModuleWidget {
         QuantizePitchesRequestedItem<Solomon<8>> *quantizePitchesRequestedItem = createMenuItem<QuantizePitchesRequestedItem<Solomon<8>>>("Quantize all nodes");
         quantizePitchesRequestedItem->module = module;
         menu->addChild(quantizePitchesRequestedItem);
+
+        Profiler::appendContextMenu(menu, module, module->profile);
     }
 
 };
@@ -1444,6 +1395,8 @@ struct SolomonWidget4 : ModuleWidget {
         QuantizePitchesRequestedItem<Solomon<4>> *quantizePitchesRequestedItem = createMenuItem<QuantizePitchesRequestedItem<Solomon<4>>>("Quantize all nodes");
         quantizePitchesRequestedItem->module = module;
         menu->addChild(quantizePitchesRequestedItem);
+
+        Profiler::appendContextMenu(menu, module, module->profile);
     }
 
 };
@@ -1610,6 +1563,8 @@ struct SolomonWidget16 : ModuleWidget {
         QuantizePitchesRequestedItem<Solomon<16>> *quantizePitchesRequestedItem = createMenuItem<QuantizePitchesRequestedItem<Solomon<16>>>("Quantize all nodes");
         quantizePitchesRequestedItem->module = module;
         menu->addChild(quantizePitchesRequestedItem);
+
+        Profiler::appendContextMenu(menu, module, module->profile);
     }
 
 };
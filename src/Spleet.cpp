@@ -4,6 +4,7 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
 
 namespace Spleet {
 
@@ -27,13 +28,24 @@ struct Spleet : Module {
         NUM_LIGHTS
     };
     
-    dsp::ClockDivider ledDivider;
-    bool chainMode;
+    Scheduler::Divider ledDivider;
+    Scheduler::Divider connectionDivider;
+
+    // Cables and the switch don't move at audio rate, so they're only checked every few samples.
+    bool chainMode = true;
+    bool sort = false;
 
     Spleet() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         ledDivider.setDivision(4096);
+        connectionDivider.setDivision(32);
         configParam(SORT_PARAM, 0.f, 1.f, 0.f, "Sort voltages on both banks");
+        updateConnections();
+    }
+
+    void updateConnections() {
+        chainMode = (inputs[POLY_INPUT + 1].isConnected()) ? false : true;
+        sort = params[SORT_PARAM].getValue();
     }
 
     // Split without sorting, faster
@@ -92,8 +104,9 @@ struct Spleet : Module {
     }
     
     void process(const ProcessArgs& args) override {
-        chainMode = (inputs[POLY_INPUT + 1].isConnected()) ? false : true;
-        (params[SORT_PARAM].getValue()) ? splitSort(args) : split(args);
+        if (connectionDivider.process())
+            updateConnections();
+        (sort) ? splitSort(args) : split(args);
         if (ledDivider.process())
             updateLeds(args);
     }	
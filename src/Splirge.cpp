@@ -4,6 +4,7 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
 
 namespace Splirge {
 
@@ -29,32 +30,50 @@ struct Splirge : Module {
         NUM_LIGHTS
     };
     
-    dsp::ClockDivider ledDivider;
+    Scheduler::Divider ledDivider;
+    Scheduler::Divider connectionDivider;
+
+    // Cables and the switch don't move at audio rate, so they're only checked every few samples.
+    // The voltages themselves are still copied every sample.
+    bool sort = false;
+    bool polyConnected = false;
+    std::array<bool, 4> mergeConnected {};
+    int lastMergeChannel = 0;
 
     Splirge() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         ledDivider.setDivision(4096);
+        connectionDivider.setDivision(32);
         configParam(SORT_PARAM, 0.f, 1.f, 0.f, "Sort voltages on both banks");
+        updateConnections();
+    }
+
+    void updateConnections() {
+        sort = params[SORT_PARAM].getValue();
+        polyConnected = inputs[POLY_INPUT].isConnected();
+        lastMergeChannel = 0;
+        for (int i = 0; i < 4; i++) {
+            mergeConnected[i] = inputs[MERGE_INPUT + i].isConnected();
+            if (mergeConnected[i]) lastMergeChannel = i + 1;
+        }
     }
     
     // Merge without sorting, faster
     void merge(const ProcessArgs& args) {
-        int lastMergeChannel = 0;
-        for (int i = 0; i < 4; i++) {
-            if (inputs[MERGE_INPUT + i].isConnected()) {
-                outputs[POLY_OUTPUT].setVoltage(inputs[MERGE_INPUT + i].getVoltage(), i);
-                lastMergeChannel = i+1;
-            } else {
-                outputs[POLY_OUTPUT].setVoltage(0, i);
-            }
-        }
+        for (int i = 0; i < lastMergeChannel; i++)
+            outputs[POLY_OUTPUT].setVoltage( (mergeConnected[i]) ? inputs[MERGE_INPUT + i].getVoltage() : 0.f, i);
         outputs[POLY_OUTPUT].setChannels(lastMergeChannel);
     }
 
     // Split without sorting, faster
     void split(const ProcessArgs& args) {
-        for (int i = 0; i < 4; i++)
-            outputs[SPLIT_OUTPUT + i].setVoltage( (inputs[POLY_INPUT].isConnected()) ? inputs[POLY_INPUT].getVoltage(i) : inputs[MERGE_INPUT + i].getVoltage());
+        if (polyConnected) {
+            for (int i = 0; i < 4; i++)
+                outputs[SPLIT_OUTPUT + i].setVoltage(inputs[POLY_INPUT].getVoltage(i));
+        } else {
+            for (int i = 0; i < 4; i++)
+                outputs[SPLIT_OUTPUT + i].setVoltage(inputs[MERGE_INPUT + i].getVoltage());
+        }
     }
 
     // Merge with sorting
@@ -62,7 +81,7 @@ struct Splirge : Module {
         std::array<float, 4> mergedVoltages;
         int connected = 0;
         for (int i = 0; i < 4; i++) {
-            if (inputs[MERGE_INPUT + i].isConnected()) {
+            if (mergeConnected[i]) {
                 mergedVoltages[i] = inputs[MERGE_INPUT + i].getVoltage();
                 connected = i + 1;
             } else {
@@ -81,17 +100,16 @@ struct Splirge : Module {
         int connected = 0;
 
         // How many connected inputs?
-        if (inputs[POLY_INPUT].isConnected()) {
+        if (polyConnected) {
             connected = inputs[POLY_INPUT].getChannels();
         } else { // Internal default wiring
-            for (int i = 0; i < 4; i++)
-                connected = (inputs[MERGE_INPUT + i].isConnected()) ? i + 1 : connected;
+            connected = lastMergeChannel;
         }
         
         // Fill array
         for (int i = 0; i < 4; i++)
             if (i < connected)
-                splitVoltages[i] = (inputs[POLY_INPUT].isConnected()) ? inputs[POLY_INPUT].getVoltage(i) : inputs[MERGE_INPUT + i].getVoltage();
+                splitVoltages[i] = (polyConnected) ? inputs[POLY_INPUT].getVoltage(i) : inputs[MERGE_INPUT + i].getVoltage();
         
         // Sort and output
         std::sort(splitVoltages.begin(), splitVoltages.begin() + connected);
@@ -128,7 +146,9 @@ struct Splirge : Module {
     }
 
     void process(const ProcessArgs& args) override {
-        if (params[SORT_PARAM].getValue()) {
+        if (connectionDivider.process())
+            updateConnections();
+        if (sort) {
             mergeSort(args);
             splitSort(args);
         } else {
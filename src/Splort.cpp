@@ -4,6 +4,7 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
 
 namespace Splort {
 
@@ -29,12 +30,25 @@ struct Splort : Module {
         NUM_LIGHTS
     };
     
-    dsp::ClockDivider ledDivider;
+    Scheduler::Divider ledDivider;
+    Scheduler::Divider connectionDivider;
+
+    // Cables and the switch don't move at audio rate, so they're only checked every few samples.
+    // The voltages and channel counts are still read every sample.
+    bool sort = false;
+    bool linkConnected = false;
 
     Splort() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         ledDivider.setDivision(256);
+        connectionDivider.setDivision(32);
         configParam(SORT_PARAM, 0.f, 1.f, 0.f, "Sort voltages");
+        updateConnections();
+    }
+
+    void updateConnections() {
+        sort = params[SORT_PARAM].getValue();
+        linkConnected = inputs[LINK_INPUT].isConnected();
     }
     
     // Split without sorting, faster
@@ -50,22 +64,22 @@ struct Splort : Module {
 
         // How many connected inputs?
         connected = inputs[POLY_INPUT].getChannels();
-        if (! inputs[LINK_INPUT].isConnected())
+        if (! linkConnected)
             outputs[LINK_OUTPUT].setChannels(connected);
 
         // Fill array
         for (int i = 0; i < 16; i++) {
             if (i < connected) {
                 splitVoltages[i][0] = inputs[POLY_INPUT].getVoltage(i);
-                splitVoltages[i][1] = (inputs[LINK_INPUT].isConnected()) ? inputs[LINK_INPUT].getVoltage(i) : (i + 1.f) * 0.1f;
+                splitVoltages[i][1] = (linkConnected) ? inputs[LINK_INPUT].getVoltage(i) : (i + 1.f) * 0.1f;
             } else {
                 splitVoltages[i][0] = 0.0f;
-                splitVoltages[i][1] = (inputs[LINK_INPUT].isConnected()) ? inputs[LINK_INPUT].getVoltage(i) : 0.f;
+                splitVoltages[i][1] = (linkConnected) ? inputs[LINK_INPUT].getVoltage(i) : 0.f;
             }
         }
         
         // Sort
-        if (inputs[LINK_INPUT].isConnected()) { // Sort by 2nd member of array.
+        if (linkConnected) { // Sort by 2nd member of array.
             std::sort(splitVoltages.begin(), splitVoltages.begin() + connected, [](const std::array<float, 2> &left, const std::array<float, 2> &right) {
                 if (left[1] == 0.f)
                     return false;
@@ -78,24 +92,24 @@ struct Splort : Module {
         // Output
         for (int i = 0; i < 16; i++) {
             outputs[SPLIT_OUTPUT + i].setVoltage(splitVoltages[i][0]);
-            if (! inputs[LINK_INPUT].isConnected())
+            if (! linkConnected)
                 outputs[LINK_OUTPUT].setVoltage(splitVoltages[i][1], i);
         }
     }
     
     void chainLink(const ProcessArgs& args) {
-        if (inputs[LINK_INPUT].isConnected()) {
+        if (linkConnected) {
             outputs[LINK_OUTPUT].setChannels(inputs[LINK_INPUT].getChannels());
             for (int i = 0; i < 16; i++)
                 outputs[LINK_OUTPUT].setVoltage(inputs[LINK_INPUT].getVoltage(i), i);
         } else {
-            if (! params[SORT_PARAM].getValue())
+            if (! sort)
                 outputs[LINK_OUTPUT].setChannels(0);
         }
     }
     
     void updateLeds(const ProcessArgs& args) {
-        if ( (params[SORT_PARAM].getValue()) or (inputs[LINK_INPUT].isConnected()) ) {
+        if (sort or linkConnected) {
             lights[LINK_IN_LIGHT].setBrightness(1.f);
             lights[LINK_OUT_LIGHT].setBrightness(1.f);
         } else {
@@ -107,7 +121,9 @@ struct Splort : Module {
     }
     
     void process(const ProcessArgs& args) override {
-        (params[SORT_PARAM].getValue()) ? splitSortLink(args) : split(args);
+        if (connectionDivider.process())
+            updateConnections();
+        (sort) ? splitSortLink(args) : split(args);
         chainLink(args); // Chain link inputs, whether sorting or not
         if (ledDivider.process())
             updateLeds(args);
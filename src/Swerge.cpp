@@ -4,6 +4,7 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
 
 namespace Swerge {
 
@@ -26,53 +27,55 @@ struct Swerge : Module {
         NUM_LIGHTS
     };
     
-    dsp::ClockDivider ledDivider;
-    bool chainMode;
+    Scheduler::Divider ledDivider;
+    Scheduler::Divider connectionDivider;
+
+    // Cables and the switch don't move at audio rate, so they're only checked every few samples.
+    // The voltages themselves are still copied every sample.
+    bool chainMode = true;
+    bool sort = false;
+    std::array<bool, 8> mergeConnected {};
+    int lastMergeChannel[2] = {0, 0};
 
     Swerge() {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
         ledDivider.setDivision(4096);
+        connectionDivider.setDivision(32);
         configParam(SORT_PARAM, 0.f, 1.f, 0.f, "Sort voltages on both banks");
+        updateConnections();
+    }
+
+    void updateConnections() {
+        chainMode = (outputs[POLY_OUTPUT + 0].isConnected()) ? false : true;
+        sort = params[SORT_PARAM].getValue();
+        for (int i = 0; i < 8; i++) mergeConnected[i] = inputs[MERGE_INPUT + i].isConnected();
+
+        // The first bank is always inputs 1-4. The second is 5-8, or 1-8 when chained.
+        lastMergeChannel[0] = 0;
+        for (int i = 0; i < 4; i++)
+            if (mergeConnected[i]) lastMergeChannel[0] = i + 1;
+        lastMergeChannel[1] = 0;
+        if (chainMode) {
+            for (int i = 0; i < 8; i++)
+                if (mergeConnected[i]) lastMergeChannel[1] = i + 1;
+        } else {
+            for (int i = 0; i < 4; i++)
+                if (mergeConnected[i + 4]) lastMergeChannel[1] = i + 1;
+        }
     }
     
     // Merge without sorting, faster
     void merge(const ProcessArgs& args) {
-        int lastMergeChannel = 0;
-        
         // Set first bank normally
-        for (int i = 0; i < 4; i++) {
-            if (inputs[MERGE_INPUT + i].isConnected()) {
-                outputs[POLY_OUTPUT + 0].setVoltage(inputs[MERGE_INPUT + i].getVoltage(), i);
-                lastMergeChannel = i+1;
-            } else {
-                outputs[POLY_OUTPUT + 0].setVoltage(0.f, i);
-            }
-        }
-        outputs[POLY_OUTPUT + 0].setChannels(lastMergeChannel);
-        
-        if (chainMode) { // Chain first and second bank
-            lastMergeChannel = 0;
-            for (int i = 0; i < 8; i++) {
-                if (inputs[MERGE_INPUT + i ].isConnected()) {
-                    outputs[POLY_OUTPUT + 1].setVoltage(inputs[MERGE_INPUT + i].getVoltage(), i);
-                    lastMergeChannel = i+1;
-                } else {
-                    outputs[POLY_OUTPUT + 1].setVoltage(0.f, i);
-                }
-            }
-            outputs[POLY_OUTPUT + 1].setChannels(lastMergeChannel);
-        } else { // Set second bank normally
-            lastMergeChannel = 0;
-            for (int i = 0; i < 4; i++) {
-                if (inputs[MERGE_INPUT + i + 4].isConnected()) {
-                    outputs[POLY_OUTPUT + 1].setVoltage(inputs[MERGE_INPUT + i + 4].getVoltage(), i);
-                    lastMergeChannel = i+1;
-                } else {
-                    outputs[POLY_OUTPUT + 1].setVoltage(0.f, i);
-                }
-            }
-            outputs[POLY_OUTPUT + 1].setChannels(lastMergeChannel);
-        }
+        for (int i = 0; i < lastMergeChannel[0]; i++)
+            outputs[POLY_OUTPUT + 0].setVoltage( (mergeConnected[i]) ? inputs[MERGE_INPUT + i].getVoltage() : 0.f, i);
+        outputs[POLY_OUTPUT + 0].setChannels(lastMergeChannel[0]);
+
+        // Chain first and second bank, or set second bank normally
+        int offset = (chainMode) ? 0 : 4;
+        for (int i = 0; i < lastMergeChannel[1]; i++)
+            outputs[POLY_OUTPUT + 1].setVoltage( (mergeConnected[i + offset]) ? inputs[MERGE_INPUT + i + offset].getVoltage() : 0.f, i);
+        outputs[POLY_OUTPUT + 1].setChannels(lastMergeChannel[1]);
     }
     
     // Merge with sorting. Ugly CTRL-V code but it gets the job done.
@@ -83,7 +86,7 @@ struct Swerge : Module {
         // Fist bank normally
         connected = 0;
         for (int i = 0; i < 4; i++) {
-            if (inputs[MERGE_INPUT + i].isConnected()) {
+            if (mergeConnected[i]) {
                 mergedVoltages[i] = inputs[MERGE_INPUT + i].getVoltage();
                 connected = i + 1;
             } else {
@@ -99,7 +102,7 @@ struct Swerge : Module {
         if (chainMode) { // Chain first and second
             connected = 0;
             for (int i = 0; i < 8; i++) {
-                if (inputs[MERGE_INPUT + i].isConnected()) {
+                if (mergeConnected[i]) {
                     mergedVoltages[i] = inputs[MERGE_INPUT + i].getVoltage();
                     connected = i + 1;
                 } else {
@@ -113,7 +116,7 @@ struct Swerge : Module {
         } else { // No chaining, do 2nd normally
             connected = 0;
             for (int i = 0; i < 4; i++) {
-                if (inputs[MERGE_INPUT + i + 4].isConnected()) {
+                if (mergeConnected[i + 4]) {
                     mergedVoltages[i] = inputs[MERGE_INPUT + i + 4].getVoltage();
                     connected = i + 1;
                 } else {
@@ -134,19 +137,20 @@ struct Swerge : Module {
         lights[POLY_LIGHT + 0].setBrightness(0.f);
         lights[POLY_LIGHT + 1].setBrightness(0.f);
         for (int i = 0; i < 4; i++)
-            if (inputs[MERGE_INPUT + i].isConnected()) {
+            if (mergeConnected[i]) {
                 lights[POLY_LIGHT + 0].setBrightness(1.f);
                 if (chainMode)
                     lights[POLY_LIGHT + 1].setBrightness(1.f);
             }
         for (int i = 4; i < 8; i++)
-            if (inputs[MERGE_INPUT + i].isConnected())
+            if (mergeConnected[i])
                 lights[POLY_LIGHT + 1].setBrightness(1.f);
     }
     
     void process(const ProcessArgs& args) override {
-        chainMode = (outputs[POLY_OUTPUT + 0].isConnected()) ? false : true;
-        (params[SORT_PARAM].getValue()) ? mergeSort(args) : merge(args);
+        if (connectionDivider.process())
+            updateConnections();
+        (sort) ? mergeSort(args) : merge(args);
         if (ledDivider.process())
             updateLeds(args);
     }	
@@ -4,8 +4,212 @@ This program is distributed in the hope that it will be useful, but WITHOUT ANY
 You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
 */
 #include "plugin.hpp"
+#include "scheduler.hpp"
+#include "expander.hpp"
+#include <chrono>
 
 // This module is to make all sorts of tests without having to recompile too much or deal with complex code interactions.
+// It's not in the plugin by default: uncomment it in plugin.cpp and plugin.hpp for dev builds.
+// The benchmarks run from the context menu and write their results in log.txt.
+// Only what needs Rack lives here: the pure DSP benchmarks and tests run headless with `make bench` and `make test`.
+
+namespace Benchmark {
+
+const float SAMPLE_RATES[3] = {44100.f, 96000.f, 192000.f};
+const int CHANNELS[2] = {1, 16};
+
+// Keeps the compiler from optimizing away what we measure
+volatile float sink = 0.f;
+
+inline double nanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A fresh instance with all the inputs and outputs considered connected.
+// setChannels() won't touch a disconnected port, so this does what the engine does with cables.
+inline Module* createModule(Model* model, int channels) {
+    Module* module = model->createModule();
+    module->onSampleRateChange();
+    for (Input& input : module->inputs) input.channels = channels;
+    for (Output& output : module->outputs) output.channels = 1;
+    return module;
+}
+
+// A 2Hz saw from -5V to 5V, with a different offset on each channel
+inline void feedInputs(Module* module, float& phase, int channels, float sampleTime) {
+    phase += 2.f * sampleTime;
+    if (phase >= 1.f) phase -= 1.f;
+    for (Input& input : module->inputs) {
+        for (int c = 0; c < channels; c++) input.setVoltage(phase * 10.f - 5.f + c * 0.1f, c);
+    }
+}
+
+// Runs one second worth of audio through a fresh instance of the module, returns ns/sample.
+// `dataJ` is loaded into it first, like a patch would, to benchmark its context menu settings.
+inline double moduleNsPerSample(Model* model, float sampleRate, int channels, json_t* dataJ = NULL) {
+    Module* module = createModule(model, channels);
+    if (dataJ) module->dataFromJson(dataJ);
+    Module::ProcessArgs args;
+    args.sampleRate = sampleRate;
+    args.sampleTime = 1.f / sampleRate;
+
+    int frames = (int) sampleRate;
+    float phase = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        feedInputs(module, phase, channels, args.sampleTime);
+        module->process(args);
+    }
+    double ns = nanosecondsSince(start) / frames;
+
+    delete module;
+    return ns;
+}
+
+inline void runModules() {
+    // Qqqq, Quack and Q< must stay first, see below
+    std::vector<std::pair<std::string, Model*>> models = {
+        {"Qqqq", modelQqqq},
+        {"Quack", modelQuack},
+        {"Q<", modelQ},
+        {"Quale", modelQuale},
+        {"Darius", modelDarius},
+        {"Solomon4", modelSolomon4},
+        {"Solomon8", modelSolomon8},
+        {"Solomon16", modelSolomon16},
+        {"Splort", modelSplort},
+        {"Smerge", modelSmerge},
+        {"Spleet", modelSpleet},
+        {"Swerge", modelSwerge},
+        {"Splirge", modelSplirge},
+    };
+    // Arcane reads files and Undular moves the rack around, they don't belong in a benchmark.
+    for (auto& m : models) {
+        for (float sampleRate : SAMPLE_RATES) {
+            for (int channels : CHANNELS) {
+                double ns = moduleNsPerSample(m.second, sampleRate, channels);
+                INFO("Benchmark: %-10s %6.0fHz %2d ch: %8.1f ns/sample", m.first.c_str(), sampleRate, channels, ns);
+            }
+        }
+    }
+
+    // The quantizers again, quantizing every sample instead of at control rate
+    json_t* audioRateJ = json_object();
+    json_object_set_new(audioRateJ, "audioRate", json_true());
+    for (int i = 0; i < 3; i++) {
+        for (float sampleRate : SAMPLE_RATES) {
+            for (int channels : CHANNELS) {
+                double ns = moduleNsPerSample(models[i].second, sampleRate, channels, audioRateJ);
+                INFO("Benchmark: %-10s %6.0fHz %2d ch: %8.1f ns/sample, audio rate", models[i].first.c_str(), sampleRate, channels, ns);
+            }
+        }
+    }
+    json_decref(audioRateJ);
+}
+
+// Many instances running together, like in a big patch. What matters for dropouts is the cost of
+// the worst sample, when control-rate work lines up, so this reports the spread, not just the mean.
+// Compares everything firing on the same sample with the staggered scheduler.
+inline void runScheduler() {
+    const float SAMPLE_RATE = 44100.f;
+    const int FRAMES = 8192;
+    Module::ProcessArgs args;
+    args.sampleRate = SAMPLE_RATE;
+    args.sampleTime = 1.f / SAMPLE_RATE;
+    Model* models[3] = {modelDarius, modelQqqq, modelSolomon8};
+
+    for (int instances : {1, 8, 32, 128}) {
+        for (bool staggered : {false, true}) {
+            // Phases get picked when the modules are created
+            Scheduler::staggered() = staggered;
+            std::vector<Module*> modules;
+            for (int i = 0; i < instances; i++) modules.push_back(createModule(models[i % 3], 1));
+            Scheduler::staggered() = true;
+
+            std::vector<double> frameNs;
+            float phase = 0.f;
+            for (int i = 0; i < FRAMES; i++) {
+                auto start = std::chrono::steady_clock::now();
+                for (Module* module : modules) {
+                    feedInputs(module, phase, 1, args.sampleTime);
+                    module->process(args);
+                }
+                frameNs.push_back(nanosecondsSince(start));
+            }
+            for (Module* module : modules) delete module;
+
+            std::sort(frameNs.begin(), frameNs.end());
+            double mean = 0.0;
+            for (double ns : frameNs) mean += ns;
+            mean /= FRAMES;
+            INFO("Benchmark: %3d instances %-9s mean %9.1f p99 %9.1f max %9.1f ns/sample", instances, staggered ? "staggered" : "together",
+                mean, frameNs[FRAMES * 99 / 100], frameNs[FRAMES - 1]);
+        }
+    }
+}
+
+// A chain of 16 Qqqqs, each the expander of the one on its left. Reports what the whole chain costs
+// per sample once nothing changes, and how many samples a new scale on the first one takes to reach the last.
+// Processing them right to left is the worst case for anything that passes the scale on one module at a time.
+inline void runExpanderChain() {
+    const int LENGTH = 16;
+    const int FRAMES = 44100;
+    Module::ProcessArgs args;
+    args.sampleRate = 44100.f;
+    args.sampleTime = 1.f / args.sampleRate;
+
+    for (bool reversed : {false, true}) {
+        std::vector<Module*> chain;
+        for (int i = 0; i < LENGTH; i++) {
+            Module* module = createModule(modelQqqq, 0);
+            if (i > 0) {
+                module->leftExpander.module = chain.back();
+                module->leftExpander.moduleId = chain.back()->id;
+                chain.back()->rightExpander.module = module;
+                chain.back()->rightExpander.moduleId = module->id;
+            }
+            chain.push_back(module);
+        }
+        auto step = [&]() {
+            for (int i = 0; i < LENGTH; i++) chain[reversed ? LENGTH - 1 - i : i]->process(args);
+        };
+        for (int i = 0; i < 1024; i++) step();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < FRAMES; i++) step();
+        double ns = nanosecondsSince(start) / FRAMES;
+
+        // Turn the key knob of the first one, and wait for the last one to follow
+        for (ParamQuantity* paramQuantity : chain.front()->paramQuantities) {
+            if (paramQuantity->label == "Key") paramQuantity->setValue(7.f);
+        }
+        const Expander::ScaleOutlet* first = Expander::outletOf(chain.front());
+        const Expander::ScaleOutlet* last = Expander::outletOf(chain.back());
+        uint64_t generation = first->read().generation;
+        int samples = 0;
+        while (samples < FRAMES and (first->read().generation == generation or last->read().scale != first->read().scale)) {
+            step();
+            samples++;
+        }
+        for (Module* module : chain) delete module;
+
+        INFO("Benchmark: %d Qqqq chain %-13s %8.1f ns/sample, new scale reaches the end in %d samples", LENGTH,
+            reversed ? "right to left" : "left to right", ns, samples);
+    }
+}
+
+inline void run() {
+    INFO("Benchmark: starting");
+    runModules();
+    runScheduler();
+    runExpanderChain();
+    INFO("Benchmark: done");
+}
+
+} // Benchmark
+
+
+
 
 struct Test : Module {
     enum ParamIds {
@@ -43,6 +247,12 @@ struct Test : Module {
 
 struct TestWidget : ModuleWidget {
 
+    struct RunBenchmarkItem : MenuItem {
+        void onAction(const event::Action &e) override {
+            Benchmark::run();
+        }
+    };
+
     TestWidget(Test* module) {
         setModule(module);
         setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/faceplates/Test.svg")));
@@ -58,6 +268,11 @@ struct TestWidget : ModuleWidget {
         }
 
     }
+
+    void appendContextMenu(ui::Menu *menu) override {
+        menu->addChild(new MenuSeparator());
+        menu->addChild(createMenuItem<RunBenchmarkItem>("Run benchmarks (results in log.txt)"));
+    }
 };
 
 Model* modelTest = createModel<Test, TestWidget>("Test");
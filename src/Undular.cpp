@@ -10,6 +10,7 @@ You should have received a copy of the GNU General Public License along with thi
 // RACK_GRID_WIDTH  = 1hp  =  15px
 
 #include "plugin.hpp"
+#include "scheduler.hpp"
 #include <settings.hpp>
 
 namespace Undular {
@@ -77,7 +78,7 @@ struct Undular : Module {
     dsp::SchmittTrigger dTrigger;
     dsp::SchmittTrigger lTrigger;
     dsp::SchmittTrigger rTrigger;
-    dsp::ClockDivider scrollDivider;
+    Scheduler::Divider scrollDivider;
     math::Vec position;
     
     ~Undular() { 
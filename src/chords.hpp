@@ -0,0 +1,569 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+// Native chord symbol and Roman numeral parsing, for Qqqq's lead sheet import.
+//
+// This is a port of exactly what the Tonal.js snippets in javascript-libraries.hpp do, quirks
+// included, so that both give the very same [[0,4,7],...] results. A few of those quirks:
+// - Only the first ( and ) of the whole text are removed.
+// - Slash chords only check that the bass is in the chord, they don't change the notes.
+// - Chords without a tonic, like "maj7", give -60 for every note.
+// - Notes can end up outside of 0-11, e.g. Cb is -1 and the 13th of B13 is 20.
+// It's table-driven, takes microseconds, and doesn't need a Javascript runtime.
+//
+// Text that would break the Javascript string literal (quotes, backslashes) simply gets parsed
+// like any other text here, so that's the one place where results differ.
+namespace Chords {
+
+// Chord dictionary from Tonal.js 4.0.1 (MIT, see javascript-libraries.hpp): intervals, name, aliases.
+// The order matters: when two entries share a key, the last one wins, same as in Tonal.
+const char* const CHORD_TYPES[][3] = {
+    {"1P 3M 5P", "major", "M "},
+    {"1P 3M 5P 7M", "major seventh", "maj7 Δ ma7 M7 Maj7"},
+    {"1P 3M 5P 7M 9M", "major ninth", "maj9 Δ9"},
+    {"1P 3M 5P 7M 9M 13M", "major thirteenth", "maj13 Maj13"},
+    {"1P 3M 5P 6M", "sixth", "6 add6 add13 M6"},
+    {"1P 3M 5P 6M 9M", "sixth/ninth", "6/9 69"},
+    {"1P 3M 5P 7M 11A", "lydian", "maj#4 Δ#4 Δ#11"},
+    {"1P 3M 6m 7M", "major seventh flat sixth", "M7b6"},
+    {"1P 3m 5P", "minor", "m min -"},
+    {"1P 3m 5P 7m", "minor seventh", "m7 min7 mi7 -7"},
+    {"1P 3m 5P 7M", "minor/major seventh", "m/ma7 m/maj7 mM7 mMaj7 m/M7 -Δ7 mΔ"},
+    {"1P 3m 5P 6M", "minor sixth", "m6"},
+    {"1P 3m 5P 7m 9M", "minor ninth", "m9"},
+    {"1P 3m 5P 7m 9M 11P", "minor eleventh", "m11"},
+    {"1P 3m 5P 7m 9M 13M", "minor thirteenth", "m13"},
+    {"1P 3m 5d", "diminished", "dim ° o"},
+    {"1P 3m 5d 7d", "diminished seventh", "dim7 °7 o7"},
+    {"1P 3m 5d 7m", "half-diminished", "m7b5 ø"},
+    {"1P 3M 5P 7m", "dominant seventh", "7 dom"},
+    {"1P 3M 5P 7m 9M", "dominant ninth", "9"},
+    {"1P 3M 5P 7m 9M 13M", "dominant thirteenth", "13"},
+    {"1P 3M 5P 7m 11A", "lydian dominant seventh", "7#11 7#4"},
+    {"1P 3M 5P 7m 9m", "dominant flat ninth", "7b9"},
+    {"1P 3M 5P 7m 9A", "dominant sharp ninth", "7#9"},
+    {"1P 3M 7m 9m", "altered", "alt7"},
+    {"1P 4P 5P", "suspended fourth", "sus4"},
+    {"1P 2M 5P", "suspended second", "sus2"},
+    {"1P 4P 5P 7m", "suspended fourth seventh", "7sus4"},
+    {"1P 5P 7m 9M 11P", "eleventh", "11"},
+    {"1P 4P 5P 7m 9m", "suspended fourth flat ninth", "b9sus phryg"},
+    {"1P 5P", "fifth", "5"},
+    {"1P 3M 5A", "augmented", "aug + +5"},
+    {"1P 3M 5A 7M", "augmented seventh", "maj7#5 maj7+5 +maj7"},
+    {"1P 3M 5P 7M 9M 11A", "major sharp eleventh (lydian)", "maj9#11 Δ9#11"},
+    {"1P 2M 4P 5P", "", "sus24 sus4add9"},
+    {"1P 3M 13m", "", "Mb6"},
+    {"1P 3M 5A 7M 9M", "", "maj9#5 Maj9#5"},
+    {"1P 3M 5A 7m", "", "7#5 +7 7aug aug7"},
+    {"1P 3M 5A 7m 9A", "", "7#5#9 7alt"},
+    {"1P 3M 5A 7m 9M", "", "9#5 9+"},
+    {"1P 3M 5A 7m 9M 11A", "", "9#5#11"},
+    {"1P 3M 5A 7m 9m", "", "7#5b9"},
+    {"1P 3M 5A 7m 9m 11A", "", "7#5b9#11"},
+    {"1P 3M 5A 9A", "", "+add#9"},
+    {"1P 3M 5A 9M", "", "M#5add9 +add9"},
+    {"1P 3M 5P 6M 11A", "", "M6#11 M6b5 6#11 6b5"},
+    {"1P 3M 5P 6M 7M 9M", "", "M7add13"},
+    {"1P 3M 5P 6M 9M 11A", "", "69#11"},
+    {"1P 3M 5P 6m 7m", "", "7b6"},
+    {"1P 3M 5P 7M 9A 11A", "", "maj7#9#11"},
+    {"1P 3M 5P 7M 9M 11A 13M", "", "M13#11 maj13#11 M13+4 M13#4"},
+    {"1P 3M 5P 7M 9m", "", "M7b9"},
+    {"1P 3M 5P 7m 11A 13m", "", "7#11b13 7b5b13"},
+    {"1P 3M 5P 7m 13M", "", "7add6 67 7add13"},
+    {"1P 3M 5P 7m 9A 11A", "", "7#9#11 7b5#9"},
+    {"1P 3M 5P 7m 9A 11A 13M", "", "13#9#11"},
+    {"1P 3M 5P 7m 9A 11A 13m", "", "7#9#11b13"},
+    {"1P 3M 5P 7m 9A 13M", "", "13#9"},
+    {"1P 3M 5P 7m 9A 13m", "", "7#9b13"},
+    {"1P 3M 5P 7m 9M 11A", "", "9#11 9+4 9#4"},
+    {"1P 3M 5P 7m 9M 11A 13M", "", "13#11 13+4 13#4"},
+    {"1P 3M 5P 7m 9M 11A 13m", "", "9#11b13 9b5b13"},
+    {"1P 3M 5P 7m 9m 11A", "", "7b9#11 7b5b9"},
+    {"1P 3M 5P 7m 9m 11A 13M", "", "13b9#11"},
+    {"1P 3M 5P 7m 9m 11A 13m", "", "7b9b13#11 7b9#11b13 7b5b9b13"},
+    {"1P 3M 5P 7m 9m 13M", "", "13b9"},
+    {"1P 3M 5P 7m 9m 13m", "", "7b9b13"},
+    {"1P 3M 5P 7m 9m 9A", "", "7b9#9"},
+    {"1P 3M 5P 9M", "", "Madd9 2 add9 add2"},
+    {"1P 3M 5P 9m", "", "Maddb9"},
+    {"1P 3M 5d", "", "Mb5"},
+    {"1P 3M 5d 6M 7m 9M", "", "13b5"},
+    {"1P 3M 5d 7M", "", "M7b5"},
+    {"1P 3M 5d 7M 9M", "", "M9b5"},
+    {"1P 3M 5d 7m", "", "7b5"},
+    {"1P 3M 5d 7m 9M", "", "9b5"},
+    {"1P 3M 7m", "", "7no5"},
+    {"1P 3M 7m 13m", "", "7b13"},
+    {"1P 3M 7m 9M", "", "9no5"},
+    {"1P 3M 7m 9M 13M", "", "13no5"},
+    {"1P 3M 7m 9M 13m", "", "9b13"},
+    {"1P 3m 4P 5P", "", "madd4"},
+    {"1P 3m 5A", "", "m#5 m+ mb6"},
+    {"1P 3m 5P 6M 9M", "", "m69"},
+    {"1P 3m 5P 6m 7M", "", "mMaj7b6"},
+    {"1P 3m 5P 6m 7M 9M", "", "mMaj9b6"},
+    {"1P 3m 5P 7M 9M", "", "mMaj9"},
+    {"1P 3m 5P 7m 11P", "", "m7add11 m7add4"},
+    {"1P 3m 5P 9M", "", "madd9"},
+    {"1P 3m 5d 6M 7M", "", "o7M7"},
+    {"1P 3m 5d 7M", "", "oM7"},
+    {"1P 3m 6m 7M", "", "mb6M7"},
+    {"1P 3m 6m 7m", "", "m7#5"},
+    {"1P 3m 6m 7m 9M", "", "m9#5"},
+    {"1P 3m 6m 7m 9M 11P", "", "m11A"},
+    {"1P 3m 6m 9m", "", "mb6b9"},
+    {"1P 2M 3m 5d 7m", "", "m9b5"},
+    {"1P 4P 5A 7M", "", "M7#5sus4"},
+    {"1P 4P 5A 7M 9M", "", "M9#5sus4"},
+    {"1P 4P 5A 7m", "", "7#5sus4"},
+    {"1P 4P 5P 7M", "", "M7sus4"},
+    {"1P 4P 5P 7M 9M", "", "M9sus4"},
+    {"1P 4P 5P 7m 9M", "", "9sus4 9sus"},
+    {"1P 4P 5P 7m 9M 13M", "", "13sus4 13sus"},
+    {"1P 4P 5P 7m 9m 13m", "", "7sus4b9b13 7b9b13sus4"},
+    {"1P 4P 7m 10m", "", "4 quartal"},
+    {"1P 5P 7m 9m 11P", "", "11b9"},
+};
+
+const int NUM_CHORD_TYPES = sizeof(CHORD_TYPES) / sizeof(CHORD_TYPES[0]);
+
+const char* const LETTERS = "CDEFGAB";
+const char* const ROMAN_NUMERALS[7] = {"I", "II", "III", "IV", "V", "VI", "VII"};
+const int STEP_SEMITONES[7] = {0, 2, 4, 5, 7, 9, 11};
+// Where each step sits on the circle of fifths, C being 0
+const int STEP_FIFTHS[7] = {0, 2, 4, -1, 1, 3, 5};
+// The other way around, starting from F
+const int FIFTHS_STEPS[7] = {3, 0, 4, 1, 5, 2, 6};
+// Octaves spanned by going around the circle of fifths to reach each step
+const int STEP_FIFTHS_OCTAVES[7] = {0, 1, 2, -1, 0, 1, 2};
+
+
+// Floor division and modulo, for going around the circle of fifths both ways
+inline int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+inline int floorMod(int a, int b) {
+    return a - b * floorDiv(a, b);
+}
+
+inline bool isMajorable(int step) {
+    return step == 1 or step == 2 or step == 5 or step == 6;
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' and c <= '9';
+}
+
+// "b" and "bb" are flats, anything else counts as sharps. Yes, even "x": Tonal does that for Roman numerals.
+inline int accidentalToAlteration(const std::string& accidental) {
+    if (accidental.empty()) return 0;
+    return (accidental[0] == 'b') ? -(int) accidental.size() : (int) accidental.size();
+}
+
+inline std::string alterationToAccidental(int alteration) {
+    return (alteration < 0) ? std::string(-alteration, 'b') : std::string(alteration, '#');
+}
+
+inline std::string qualityName(int step, int alteration) {
+    bool majorable = isMajorable(step);
+    if (alteration == 0) return majorable ? "M" : "P";
+    if (alteration == -1 and majorable) return "m";
+    if (alteration > 0) return std::string(alteration, 'A');
+    return std::string(majorable ? -alteration - 1 : -alteration, 'd');
+}
+
+inline std::string intervalName(int step, int alteration, int octave = 0) {
+    return std::to_string(step + 1 + 7 * octave) + qualityName(step, alteration);
+}
+
+// Semitones of an ascending interval name like "3M", "13m", "5A" or "7d". -1000 if it's not one.
+inline int intervalSemitones(const std::string& name) {
+    size_t i = 0;
+    int number = 0;
+    while (i < name.size() and isDigit(name[i])) number = number * 10 + (name[i++] - '0');
+    std::string quality = name.substr(i);
+    if (number < 1 or quality.empty()) return -1000;
+    int step = (number - 1) % 7;
+    int octave = (number - 1) / 7;
+    bool majorable = isMajorable(step);
+    int alteration;
+    if (quality == "M" and majorable) {
+        alteration = 0;
+    } else if (quality == "P" and ! majorable) {
+        alteration = 0;
+    } else if (quality == "m" and majorable) {
+        alteration = -1;
+    } else if (quality.find_first_not_of('A') == std::string::npos) {
+        alteration = quality.size();
+    } else if (quality.find_first_not_of('d') == std::string::npos) {
+        alteration = majorable ? -(int) quality.size() - 1 : -(int) quality.size();
+    } else {
+        return -1000;
+    }
+    return STEP_SEMITONES[step] + alteration + 12 * octave;
+}
+
+
+// A note split the way Tonal does it: letter, accidentals, octave, and whatever is left.
+// "x" accidentals become "##".
+struct NoteTokens {
+    std::string letter;
+    std::string accidental;
+    std::string octave;
+    std::string rest;
+};
+
+inline NoteTokens tokenizeNote(const std::string& text) {
+    NoteTokens tokens;
+    size_t i = 0;
+    if (i < text.size() and ((text[i] >= 'a' and text[i] <= 'g') or (text[i] >= 'A' and text[i] <= 'G'))) {
+        tokens.letter = std::string(1, std::toupper(text[i]));
+        i++;
+    }
+    if (i < text.size() and (text[i] == '#' or text[i] == 'b' or text[i] == 'x')) {
+        char accidental = text[i];
+        while (i < text.size() and text[i] == accidental) {
+            tokens.accidental += (accidental == 'x') ? "##" : std::string(1, accidental);
+            i++;
+        }
+    }
+    size_t octaveStart = i;
+    if (i < text.size() and text[i] == '-') i++;
+    while (i < text.size() and isDigit(text[i])) i++;
+    tokens.octave = text.substr(octaveStart, i - octaveStart);
+    while (i < text.size() and (text[i] == ' ' or (text[i] >= '\t' and text[i] <= '\r'))) i++;
+    tokens.rest = text.substr(i);
+    return tokens;
+}
+
+
+struct Note {
+    bool empty = true;
+    std::string name;
+    int step = 0;
+    int alteration = 0;
+    bool hasOctave = false;
+    double octave = 0.0;
+
+    int fifths() const {
+        return STEP_FIFTHS[step] + 7 * alteration;
+    }
+
+    // In semitones, where C4 is 60. Notes without an octave are way out of MIDI range.
+    double height() const {
+        return STEP_SEMITONES[step] + alteration + 12.0 * ((hasOctave ? octave : -100.0) + 1.0);
+    }
+};
+
+inline Note parseNote(const std::string& text) {
+    Note note;
+    NoteTokens tokens = tokenizeNote(text);
+    if (tokens.letter.empty() or ! tokens.rest.empty()) return note;
+    note.empty = false;
+    note.name = tokens.letter + tokens.accidental + tokens.octave;
+    note.step = (tokens.letter[0] + 3) % 7;
+    note.alteration = accidentalToAlteration(tokens.accidental);
+    if (! tokens.octave.empty()) {
+        note.hasOctave = true;
+        // A lone "-" is NaN in Javascript, and stays out of range here too
+        note.octave = (tokens.octave == "-") ? NAN : std::strtod(tokens.octave.c_str(), NULL);
+    }
+    return note;
+}
+
+// Name of a note without octave, from its position on the circle of fifths
+inline std::string pitchClassName(int fifths) {
+    int step = FIFTHS_STEPS[floorMod(fifths + 1, 7)];
+    int alteration = floorDiv(fifths + 1, 7);
+    return std::string(1, LETTERS[step]) + alterationToAccidental(alteration);
+}
+
+// Ascending simple interval between two notes, ignoring their octaves, named the way Tonal does
+inline std::string distanceName(const Note& from, const Note& to) {
+    int fifths = to.fifths() - from.fifths();
+    int octaves = -floorDiv(7 * fifths, 12);
+    int step = FIFTHS_STEPS[floorMod(fifths + 1, 7)];
+    int alteration = floorDiv(fifths + 1, 7);
+    int octave = octaves + 4 * alteration + STEP_FIFTHS_OCTAVES[step];
+    return intervalName(step, alteration, octave);
+}
+
+
+struct ChordType {
+    std::vector<std::string> intervals;
+    std::vector<int> semitones;
+    std::vector<std::string> aliases;
+};
+
+inline std::vector<std::string> splitOnSpaces(const std::string& text) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find(' ', start);
+        parts.push_back(text.substr(start, end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    return parts;
+}
+
+// Chord types can be looked up by name, by alias, and by their pitch class set,
+// as a binary string or as a number ("100010010000" and "2192" are both major).
+struct Dictionary {
+    std::vector<ChordType> types;
+    std::map<std::string, int> keys;
+
+    Dictionary() {
+        types.resize(NUM_CHORD_TYPES);
+        for (int i = 0; i < NUM_CHORD_TYPES; i++) {
+            ChordType& type = types[i];
+            type.intervals = splitOnSpaces(CHORD_TYPES[i][0]);
+            std::string chroma(12, '0');
+            for (const std::string& interval : type.intervals) {
+                type.semitones.push_back(intervalSemitones(interval));
+                chroma[floorMod(type.semitones.back(), 12)] = '1';
+            }
+            type.aliases = splitOnSpaces(CHORD_TYPES[i][2]);
+
+            std::string name = CHORD_TYPES[i][1];
+            if (! name.empty()) keys[name] = i;
+            keys[std::to_string(std::strtol(chroma.c_str(), NULL, 2))] = i;
+            keys[chroma] = i;
+            for (const std::string& alias : type.aliases) keys[alias] = i;
+        }
+    }
+
+    const ChordType* find(const std::string& key) const {
+        std::map<std::string, int>::const_iterator found = keys.find(key);
+        return (found == keys.end()) ? NULL : &types[found->second];
+    }
+};
+
+// Built once, the first time it's needed
+inline const Dictionary& dictionary() {
+    static const Dictionary dictionary;
+    return dictionary;
+}
+
+
+struct Chord {
+    const ChordType* type = NULL;
+    Note tonic;
+
+    bool empty() const {
+        return type == NULL;
+    }
+};
+
+// A chord type, with an optional tonic and bass. The bass must be one of the chord's notes.
+inline Chord fromType(const std::string& typeName, const std::string& tonicName, const std::string& bassName) {
+    Chord chord;
+    const ChordType* type = dictionary().find(typeName);
+    Note tonic = parseNote(tonicName);
+    Note bass = parseNote(bassName);
+    if (! type or (! tonicName.empty() and tonic.empty) or (! bassName.empty() and bass.empty)) return chord;
+    if (! bass.empty) {
+        if (tonic.empty) return chord;
+        std::string distance = distanceName(tonic, bass);
+        if (std::find(type->intervals.begin(), type->intervals.end(), distance) == type->intervals.end()) return chord;
+    }
+    chord.type = type;
+    chord.tonic = tonic;
+    return chord;
+}
+
+// Splits a chord symbol into tonic and type. Digits right after the note are an octave,
+// unless they look like the start of a chord type.
+inline void tokenizeChord(const std::string& symbol, std::string& tonic, std::string& type) {
+    NoteTokens tokens = tokenizeNote(symbol);
+    const std::string& octave = tokens.octave;
+    if (tokens.letter.empty()) {
+        tonic = "";
+        type = symbol;
+    } else if (tokens.letter == "A" and tokens.rest == "ug") {
+        tonic = "";
+        type = "aug";
+    } else if (! tokens.rest.empty() or (octave != "4" and octave != "5")) {
+        if (octave == "6" or octave == "64" or octave == "7" or octave == "9" or octave == "11" or octave == "13") {
+            tonic = tokens.letter + tokens.accidental;
+            type = octave + tokens.rest;
+        } else {
+            tonic = tokens.letter + tokens.accidental + octave;
+            type = tokens.rest;
+        }
+    } else {
+        tonic = tokens.letter + tokens.accidental;
+        type = octave;
+    }
+}
+
+// A chord symbol like "Cmaj7". If it doesn't work with a tonic, maybe the whole thing is a chord type.
+inline Chord fromSymbol(const std::string& symbol) {
+    if (symbol.empty()) return Chord();
+    std::string tonic, type;
+    tokenizeChord(symbol, tonic, type);
+    Chord chord = fromType(type, tonic, "");
+    if (chord.empty()) chord = fromType(symbol, "", "");
+    return chord;
+}
+
+// Notes of a chord symbol, from the tonic on the 4th octave, as positions in the C4 octave
+inline std::vector<int> scalePositions(const std::string& symbol) {
+    std::vector<int> positions;
+    Chord chord;
+    size_t slash = symbol.find('/');
+    if (slash != std::string::npos) {
+        size_t secondSlash = symbol.find('/', slash + 1);
+        std::string bass = symbol.substr(slash + 1, (secondSlash == std::string::npos) ? std::string::npos : secondSlash - slash - 1);
+        Chord withoutBass = fromSymbol(symbol.substr(0, slash));
+        if (withoutBass.empty()) return positions;
+        chord = fromType(withoutBass.type->aliases[0], withoutBass.tonic.name, bass);
+    } else {
+        chord = fromSymbol(symbol);
+    }
+    if (chord.empty()) return positions;
+
+    Note firstNote = parseNote(chord.tonic.name + "4");
+    for (int semitones : chord.type->semitones) {
+        // What Tonal.Midi.toMidi() gives for notes it can't place, minus 60
+        int position = -60;
+        if (! firstNote.empty) {
+            double height = firstNote.height() + semitones;
+            if (height >= 0.0 and height <= 127.0) {
+                position = (int) height - 60;
+                if (position >= 12) position = position - 12;
+            }
+        }
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+// Javascript's \s, as it can show up in UTF-8 text. Returns how many bytes it's made of, 0 if it's not whitespace.
+inline int whitespaceLength(const std::string& text, size_t i) {
+    unsigned char c = text[i];
+    if (c == ' ' or (c >= '\t' and c <= '\r')) return 1;
+    if (c == 0xc2 and i + 1 < text.size() and (unsigned char) text[i + 1] == 0xa0) return 2;
+    if ((c == 0xe1 or c == 0xe2 or c == 0xe3 or c == 0xef) and i + 2 < text.size()) {
+        int codepoint = ((c & 0x0f) << 12) | (((unsigned char) text[i + 1] & 0x3f) << 6) | ((unsigned char) text[i + 2] & 0x3f);
+        if (codepoint == 0x1680 or (codepoint >= 0x2000 and codepoint <= 0x200a) or codepoint == 0x2028 or codepoint == 0x2029
+        or codepoint == 0x202f or codepoint == 0x205f or codepoint == 0x3000 or codepoint == 0xfeff) return 3;
+    }
+    return 0;
+}
+
+// Commas, hyphens, and whitespace separate chords
+inline std::vector<std::string> tokenize(std::string input) {
+    size_t found = input.find('(');
+    if (found != std::string::npos) input.erase(found, 1);
+    found = input.find(')');
+    if (found != std::string::npos) input.erase(found, 1);
+
+    std::vector<std::string> tokens;
+    std::string token;
+    size_t i = 0;
+    while (i < input.size()) {
+        int length = (input[i] == ',' or input[i] == '-') ? 1 : whitespaceLength(input, i);
+        if (length > 0) {
+            if (! token.empty()) tokens.push_back(token);
+            token.clear();
+            i += length;
+        } else {
+            token += input[i];
+            i++;
+        }
+    }
+    if (! token.empty()) tokens.push_back(token);
+    return tokens;
+}
+
+// A Roman numeral like "bVIImaj7" as a chord symbol in a key, e.g. "Bbmaj7" in C.
+// Empty if it's not a Roman numeral.
+inline std::string romanNumeralToSymbol(const std::string& tonic, const std::string& numeral) {
+    size_t i = 0;
+    if (i < numeral.size() and (numeral[i] == '#' or numeral[i] == 'b' or numeral[i] == 'x')) {
+        char accidental = numeral[i];
+        while (i < numeral.size() and numeral[i] == accidental) i++;
+    }
+    std::string accidental = numeral.substr(0, i);
+    size_t romanStart = i;
+    while (i < numeral.size() and (numeral[i] == 'I' or numeral[i] == 'V' or numeral[i] == 'i' or numeral[i] == 'v')) i++;
+    std::string roman = numeral.substr(romanStart, i - romanStart);
+    std::string chordType = numeral.substr(i);
+    if (chordType.find_first_of("IViv") != std::string::npos) return "";
+
+    std::string upper = roman;
+    for (char& c : upper) c = std::toupper(c);
+    // Mixed case numerals don't count
+    if (roman != upper) {
+        std::string lower = roman;
+        for (char& c : lower) c = std::tolower(c);
+        if (roman != lower) return "";
+    }
+    int step = -1;
+    for (int s = 0; s < 7; s++) {
+        if (upper == ROMAN_NUMERALS[s]) step = s;
+    }
+    if (step < 0) return "";
+
+    Note tonicNote = parseNote(tonic);
+    if (tonicNote.empty) return chordType;
+    int fifths = tonicNote.fifths() + STEP_FIFTHS[step] + 7 * accidentalToAlteration(accidental);
+    return pitchClassName(fifths) + chordType;
+}
+
+
+typedef std::vector<std::vector<int>> Progression;
+
+// "C em A7 G7sus4 Eb G/D G7sus4 Cmaj7"
+inline Progression leadSheet(const std::string& text) {
+    Progression progression;
+    for (const std::string& symbol : tokenize(text)) progression.push_back(scalePositions(symbol));
+    return progression;
+}
+
+// "I V vim7 V bVI bIII bVII IV", in the key of the tonic
+inline Progression romanNumerals(const std::string& tonic, const std::string& text) {
+    Progression progression;
+    for (const std::string& numeral : tokenize(text)) progression.push_back(scalePositions(romanNumeralToSymbol(tonic, numeral)));
+    return progression;
+}
+
+// Same as JSON.stringify() on the Javascript results, for comparing both
+inline std::string toJson(const Progression& progression) {
+    std::string json = "[";
+    for (size_t i = 0; i < progression.size(); i++) {
+        if (i > 0) json += ",";
+        json += "[";
+        for (size_t j = 0; j < progression[i].size(); j++) {
+            if (j > 0) json += ",";
+            json += std::to_string(progression[i][j]);
+        }
+        json += "]";
+    }
+    return json + "]";
+}
+
+} // Chords
@@ -0,0 +1,114 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <atomic>
+#include "quantizer.hpp"
+
+// How Qqqq, Quack, Q and Quale pass their scale to the module on their right.
+//
+// Every module publishes its current scale in its own outlet, and the one on its right reads it from there:
+// no Rack message flipping, no copying the scale around every tick. Each new scale gets a generation
+// number, so a receiver only has to look at the generation to know there's nothing new.
+//
+// In a chain, a module in the middle passes on what it receives with the same generation, and stamps a
+// new one when its own controls change the scale. Generations come from one counter for the whole plugin,
+// so the newest change anywhere up the chain is simply the biggest generation. A receiver looks at every
+// outlet on its left to find it, instead of waiting for each module in between to pass it on:
+// a change reaches the end of a chain of any length at the receiver's next tick.
+namespace Expander {
+
+// Whether a module talks this protocol
+inline bool isQuantizer(Module* module) {
+    return module and (module->model == modelQqqq or module->model == modelQuack
+                    or module->model == modelQ    or module->model == modelQuale);
+}
+
+// Newer scales always have bigger generations. 0 means nothing was published yet.
+inline uint64_t nextGeneration() {
+    static std::atomic<uint64_t> generation {0};
+    return ++generation;
+}
+
+// Fits in 64 bits: the scale in 12, the scene in 4, the generation in the other 48.
+struct ScaleMessage {
+    Quantizer::ScaleMask scale;
+    int scene = 0;
+    uint64_t generation = 0;
+
+    uint64_t pack() const {
+        return (generation << 16) | ((uint64_t) (scene & 15) << 12) | scale.bits;
+    }
+
+    static ScaleMessage unpack(uint64_t packed) {
+        ScaleMessage message;
+        message.scale = Quantizer::ScaleMask((uint16_t) (packed & 0xfff));
+        message.scene = (packed >> 12) & 15;
+        message.generation = packed >> 16;
+        return message;
+    }
+};
+
+// Written by its module on the audio thread, read by its neighbors from theirs, which may be another thread.
+// The modules expose it through their own rightExpander.producerMessage, which Rack leaves alone
+// as long as nobody requests a flip on it.
+struct ScaleOutlet {
+    // Whether the module passes on what it receives. Quale doesn't, the chain starts over after it.
+    bool relays = true;
+    // The audio thread's own copy of what's published
+    ScaleMessage message;
+    std::atomic<uint64_t> packed {0};
+
+    // Stamps a new generation if the scale changed. A new scene with the same scale isn't news.
+    void publish(const Quantizer::ScaleMask& scale, int scene) {
+        if (message.generation != 0 and scale == message.scale) {
+            if (scene == message.scene) return;
+        } else {
+            message.scale = scale;
+            message.generation = nextGeneration();
+        }
+        message.scene = scene;
+        packed.store(message.pack(), std::memory_order_relaxed);
+    }
+
+    // Passes on a received scale with its generation, so the chain further right doesn't see it as new
+    void forward(const ScaleMessage& received, int scene) {
+        message = received;
+        message.scene = scene;
+        packed.store(message.pack(), std::memory_order_relaxed);
+    }
+
+    ScaleMessage read() const {
+        return ScaleMessage::unpack(packed.load(std::memory_order_relaxed));
+    }
+};
+
+inline ScaleOutlet* outletOf(Module* module) {
+    return (ScaleOutlet*) module->rightExpander.producerMessage;
+}
+
+// The newest scale published on the left of a module, as if every module in between had already passed it on.
+// Generation 0 when there's no quantizer on the left.
+inline ScaleMessage receive(Module* module) {
+    ScaleMessage newest;
+    for (Module* left = module->leftExpander.module; isQuantizer(left); left = left->leftExpander.module) {
+        ScaleOutlet* outlet = outletOf(left);
+        ScaleMessage message = outlet->read();
+        if (message.generation > newest.generation) newest = message;
+        if (! outlet->relays) break;
+    }
+    return newest;
+}
+
+} // Expander
@@ -0,0 +1,57 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Handing data over to the audio thread without ever making it wait on a lock.
+namespace Handoff {
+
+// Passes the latest value from one producer to one consumer, lock-free and wait-free.
+//
+// Triple buffered: the producer and the consumer each own a buffer, and swap theirs with
+// the spare one through a single atomic. Nobody ever reads a buffer while it's being written,
+// so there are no torn values. If the producer publishes twice before the consumer looks,
+// the older value is simply skipped.
+//
+// Producer: fill writeBuffer(), then publish(). Consumer: consume() returns NULL when nothing is new.
+template <typename T>
+struct Slot {
+    static const uint8_t INDEX = 3;
+    static const uint8_t FRESH = 4;
+
+    T buffers[3];
+    // Index of the spare buffer, and whether it was published since the consumer last looked
+    std::atomic<uint8_t> spare {1};
+    uint8_t back = 0;
+    uint8_t front = 2;
+
+    T& writeBuffer() {
+        return buffers[back];
+    }
+
+    void publish() {
+        back = spare.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    T* consume() {
+        if (! (spare.load(std::memory_order_relaxed) & FRESH)) return NULL;
+        front = spare.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return &buffers[front];
+    }
+};
+
+} // Handoff
@@ -24,32 +24,124 @@
 // read that variable, and use JSON for interchange because eh that's as
 // far as I'm willing to figure out this thing.
 //
-// Spinning up a new runtime on demand is basically instant, but this stuff is
-// just to do one-off data processing. Don't go around writing an oscillator with it.
+// Spinning up a new runtime on demand is basically instant, but evaluating big libraries like
+// Tonal.js in it is not. For those, use the Pool instead: the libraries get compiled to bytecode
+// once, cached on disk, and stay loaded for the whole session.
+// Either way, this stuff is just to do one-off data processing. Don't go around writing an oscillator with it.
+//
+// Runtimes are bounded: a memory limit, a stack limit, and a time limit on each evaluation,
+// so a runaway script errors out instead of taking Rack down with it.
 // 
 // Jerry Sievert's fork of Quickjs (and advice!) were used: https://github.com/JerrySievert/QuickJS
 // See makefile for how to add it to a project.
 
 #pragma once
 #include <rack.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 // QuickJS always throws a warning here, but it works.
 #include "quickjs/quickjs.h"
 
+// The commit QuickJS was built from, passed by the makefile. QuickJS doesn't expose its bytecode version,
+// and bytecode from another build can crash it, so this is what tells cached bytecode apart.
+#ifndef QUICKJS_COMMIT
+#define QUICKJS_COMMIT "unknown"
+#endif
+
+using namespace rack;
+
 namespace Javascript {
 
+struct Limits {
+    size_t memory = 32 * 1024 * 1024;
+    // QuickJS's own default. Threads on Mac only get 512KB of stack.
+    size_t stack = 256 * 1024;
+    // For each evaluation
+    double seconds = 2.0;
+};
+
+
+// A string read out of a runtime, freed when it goes out of scope
+struct String {
+    JSContext *context = NULL;
+    const char *cString = NULL;
+
+    String(JSContext *context, const char *cString) : context(context), cString(cString) {}
+
+    String(String&& other) : context(other.context), cString(other.cString) {
+        other.cString = NULL;
+    }
+
+    String(const String&) = delete;
+    String& operator=(const String&) = delete;
+
+    ~String() {
+        if (cString) JS_FreeCString(context, cString);
+    }
+
+    // NULL if there was nothing to convert
+    const char* c_str() const {
+        return cString;
+    }
+
+    std::string str() const {
+        return cString ? std::string(cString) : std::string();
+    }
+};
+
+
+struct MemoryUsage {
+    int64_t mallocSize = 0;
+    int64_t mallocLimit = 0;
+    int64_t memoryUsedSize = 0;
+    int64_t objects = 0;
+    int64_t strings = 0;
+    int64_t functions = 0;
+
+    std::string toString() const {
+        return string::f("%lld KB allocated (limit %lld KB), %lld KB used, %lld objects, %lld strings, %lld functions",
+            (long long) mallocSize / 1024, (long long) mallocLimit / 1024, (long long) memoryUsedSize / 1024,
+            (long long) objects, (long long) strings, (long long) functions);
+    }
+};
+
+
 struct Runtime {    
     JSRuntime *runtime = NULL;
     JSContext *context = NULL;
     JSValue argv;
     JSValue globalObject;
+    Limits limits;
+    std::chrono::steady_clock::time_point deadline;
+    // The message of the last exception, if the last evaluation failed
+    std::string lastError;
+
+    // QuickJS calls this every so often while running a script. Non-zero stops the script.
+    static int interruptHandler(JSRuntime *runtime, void *opaque) {
+        Runtime *self = (Runtime*) opaque;
+        return std::chrono::steady_clock::now() > self->deadline;
+    }
 
-    Runtime () {
+    Runtime (Limits limits = Limits()) : limits(limits) {
         runtime = JS_NewRuntime();
+        JS_SetMemoryLimit(runtime, limits.memory);
+        JS_SetMaxStackSize(runtime, limits.stack);
+        JS_SetInterruptHandler(runtime, interruptHandler, this);
         context = JS_NewContext(runtime);
 
         argv = JS_NewObject(context);
         globalObject = JS_GetGlobalObject(context);
+        startClock();
     }
 
     ~Runtime () {
@@ -59,18 +151,80 @@ struct Runtime {
         if (runtime) JS_FreeRuntime(runtime);
     }
 
-    void evaluateString(std::string script) {
-        JSValue evaluatedScript = JS_Eval(context, script.c_str(), script.size(), "Evaluated script", 0);
-        JS_FreeValue(context, evaluatedScript);
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+
+    void startClock() {
+        deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limits.seconds));
+    }
+
+    // Frees the exception, keeping its message in lastError
+    void clearException() {
+        JSValue exception = JS_GetException(context);
+        String message(context, JS_ToCString(context, exception));
+        lastError = message.str();
+        JS_FreeValue(context, exception);
+    }
+
+    // Frees the result. False if the script threw, ran out of memory, or took too long.
+    bool checkResult(JSValue result) {
+        bool success = ! JS_IsException(result);
+        JS_FreeValue(context, result);
+        if (success) {
+            lastError.clear();
+        } else {
+            clearException();
+        }
+        return success;
+    }
+
+    bool evaluateString(std::string script) {
+        startClock();
+        return checkResult(JS_Eval(context, script.c_str(), script.size(), "Evaluated script", 0));
+    }
+
+    // Compiles a script to bytecode without running it. Empty if it doesn't compile.
+    std::vector<uint8_t> compile(const std::string& script) {
+        std::vector<uint8_t> bytecode;
+        startClock();
+        JSValue function = JS_Eval(context, script.c_str(), script.size(), "Compiled script", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+        if (JS_IsException(function)) {
+            clearException();
+            return bytecode;
+        }
+        size_t size = 0;
+        uint8_t *buffer = JS_WriteObject(context, &size, function, JS_WRITE_OBJ_BYTECODE);
+        JS_FreeValue(context, function);
+        if (buffer) {
+            bytecode.assign(buffer, buffer + size);
+            js_free(context, buffer);
+        }
+        return bytecode;
     }
 
-    const char* readVariableAsChar(const char* variable){
+    // Runs bytecode made by compile(). False if it can't, for example if another version of QuickJS made it.
+    bool evaluateBytecode(const std::vector<uint8_t>& bytecode) {
+        if (bytecode.empty()) return false;
+        startClock();
+        JSValue function = JS_ReadObject(context, bytecode.data(), bytecode.size(), JS_READ_OBJ_BYTECODE);
+        if (JS_IsException(function)) {
+            clearException();
+            return false;
+        }
+        return checkResult(JS_EvalFunction(context, function)); // Frees the function
+    }
+
+    String readVariable(const char* variable){
         JSValue value = JS_GetPropertyStr(context, globalObject, variable);
-        const char *readValue = JS_ToCString(context, value);
+        String readValue(context, JS_ToCString(context, value));
         JS_FreeValue(context, value);
         return readValue;
     }
 
+    std::string readVariableAsString(const char* variable){
+        return readVariable(variable).str();
+    }
+
     int32_t readVariableAsInt32(const char* variable){
         int32_t readValue = 0;
         JSValue value = JS_GetPropertyStr(context, globalObject, variable);
@@ -79,7 +233,222 @@ struct Runtime {
         return readValue;
     }
 
+    // Reference counting frees almost everything right away, this gets the cycles too
+    void collectGarbage() {
+        JS_RunGC(runtime);
+    }
+
+    MemoryUsage memoryUsage() {
+        JSMemoryUsage usage;
+        JS_ComputeMemoryUsage(runtime, &usage);
+        MemoryUsage memoryUsage;
+        memoryUsage.mallocSize = usage.malloc_size;
+        memoryUsage.mallocLimit = usage.malloc_limit;
+        memoryUsage.memoryUsedSize = usage.memory_used_size;
+        memoryUsage.objects = usage.obj_count;
+        memoryUsage.strings = usage.str_count;
+        memoryUsage.functions = usage.js_func_count;
+        return memoryUsage;
+    }
+
+};
+
 
+// FNV-1a, to tell sets of libraries apart, and to checksum cached bytecode
+inline uint64_t hash(const uint8_t* data, size_t size) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+inline uint64_t hash(const std::string& text) {
+    return hash((const uint8_t*) text.data(), text.size());
+}
+
+
+// Goes in front of cached bytecode. QuickJS doesn't check bytecode at all before running it,
+// so anything truncated, mangled, or from another build must be caught before it gets there.
+struct CacheHeader {
+    char magic[8] = {'A', 'r', 'i', 'a', 'Q', 'J', 'S', '\0'};
+    uint32_t format = 1;
+    uint32_t pointerSize = sizeof(void*);
+    uint64_t quickjs = hash(QUICKJS_COMMIT);
+    uint64_t length = 0;
+    uint64_t checksum = 0;
+
+    bool matches(const CacheHeader& other) const {
+        return std::memcmp(magic, other.magic, sizeof(magic)) == 0 and format == other.format
+            and pointerSize == other.pointerSize and quickjs == other.quickjs;
+    }
 };
 
+
+// Runtimes with a set of libraries already loaded, shared by all modules for the whole session.
+// The first time ever a set of libraries is used, it gets compiled to bytecode and cached in
+// the user folder, keyed by a hash of the sources and of the QuickJS version. After that it's only
+// a matter of loading it, and after the first job, nothing to load at all.
+// Cache files are written to a temporary file first then renamed, so a crash or two Racks sharing the
+// user folder can't leave a half-written one. Any that doesn't check out is deleted and compiled again.
+//
+// QuickJS measures its stack from wherever a runtime was created, and isn't thread-safe anyway,
+// so the runtimes never leave the pool's own thread: jobs are queued and run there, one at a time.
+struct Pool {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    // Only ever touched from the pool's thread
+    std::map<uint64_t, std::unique_ptr<Runtime>> runtimes;
+
+    Pool() {
+        std::thread t([this]() { work(); });
+        t.detach();
+    }
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return ! jobs.empty(); });
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    static std::string cacheFilename(uint64_t key) {
+        return asset::user("AriaSalvatrice/Javascript/") + string::f("%016llx", (unsigned long long) key) + ".qjsbc";
+    }
+
+    // Way more than any library needs, so a damaged length can't make us allocate gigabytes
+    static const uint64_t MAX_CACHE_SIZE = 64 * 1024 * 1024;
+
+    // Empty if there's no cache, or if it doesn't check out, in which case it's deleted
+    static std::vector<uint8_t> readCache(uint64_t key) {
+        std::vector<uint8_t> bytecode;
+        std::ifstream file(cacheFilename(key), std::ios::binary);
+        if (! file) return bytecode;
+        CacheHeader expected, header;
+        file.read((char*) &header, sizeof(header));
+        if (file and header.matches(expected) and header.length <= MAX_CACHE_SIZE) {
+            bytecode.resize(header.length);
+            file.read((char*) bytecode.data(), bytecode.size());
+            // Nothing missing, nothing extra
+            bool complete = file and file.peek() == std::ifstream::traits_type::eof();
+            if (complete and hash(bytecode.data(), bytecode.size()) == header.checksum) return bytecode;
+        }
+        file.close();
+        WARN("Javascript: discarding damaged or outdated bytecode cache %s", cacheFilename(key).c_str());
+        removeCache(key);
+        bytecode.clear();
+        return bytecode;
+    }
+
+    static void removeCache(uint64_t key) {
+        std::remove(cacheFilename(key).c_str());
+    }
+
+    static void writeCache(uint64_t key, const std::vector<uint8_t>& bytecode) {
+        system::createDirectory(asset::user("AriaSalvatrice"));
+        system::createDirectory(asset::user("AriaSalvatrice/Javascript"));
+        CacheHeader header;
+        header.length = bytecode.size();
+        header.checksum = hash(bytecode.data(), bytecode.size());
+        // Unique to this write, so another Rack writing the same cache at the same time gets its own
+        std::string temporary = cacheFilename(key) + string::f(".%016llx.tmp", (unsigned long long) random::u64());
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            file.write((const char*) &header, sizeof(header));
+            file.write((const char*) bytecode.data(), bytecode.size());
+            file.close();
+            if (! file) {
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        // Fails on Windows if another Rack got there first, which is fine, theirs is just as good
+        if (std::rename(temporary.c_str(), cacheFilename(key).c_str()) != 0) std::remove(temporary.c_str());
+    }
+
+    // Cached bytecode if possible, freshly compiled bytecode otherwise, plain source as a last resort.
+    static void load(Runtime& runtime, const std::string& source, uint64_t key) {
+        std::vector<uint8_t> cached = readCache(key);
+        if (runtime.evaluateBytecode(cached)) return;
+        // Checked out but QuickJS still wouldn't have it
+        if (! cached.empty()) removeCache(key);
+        std::vector<uint8_t> bytecode = runtime.compile(source);
+        if (runtime.evaluateBytecode(bytecode)) {
+            writeCache(key, bytecode);
+            return;
+        }
+        if (! runtime.evaluateString(source)) WARN("Javascript: could not load libraries: %s", runtime.lastError.c_str());
+    }
+
+    // Pool's thread only
+    Runtime& runtimeFor(const std::vector<std::string>& libraries) {
+        std::string source;
+        for (const std::string& library : libraries) {
+            source.append(library);
+            source.append("\n");
+        }
+        uint64_t key = hash(QUICKJS_COMMIT "\n" + source);
+
+        std::unique_ptr<Runtime>& runtime = runtimes[key];
+        if (! runtime) {
+            runtime.reset(new Runtime());
+            load(*runtime, source, key);
+            INFO("Javascript: libraries loaded, %s", runtime->memoryUsage().toString().c_str());
+        }
+        return *runtime;
+    }
+
+    // Queues a job, and returns right away. Nothing can be assumed about when it runs,
+    // so the job must own everything it uses.
+    void post(const std::vector<std::string>& libraries, std::function<void(Runtime&)> job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back([this, libraries, job]() {
+            Runtime& runtime = runtimeFor(libraries);
+            job(runtime);
+            // Whatever the job left behind goes, so repeated imports keep memory flat
+            runtime.collectGarbage();
+        });
+        wake.notify_one();
+    }
+
+    // For work that doesn't need Javascript, but shouldn't get its own thread either: file imports and such.
+    // Runs in turn with the other jobs.
+    void post(std::function<void()> job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+        wake.notify_one();
+    }
+
+    // Same as post(), but waits until the job is done
+    void run(const std::vector<std::string>& libraries, std::function<void(Runtime&)> job) {
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        bool done = false;
+        post(libraries, [&](Runtime& runtime) {
+            job(runtime);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+            doneCondition.notify_one();
+        });
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [&]() { return done; });
+    }
+};
+
+
+// The one pool for the whole plugin. Never destroyed, on purpose: its thread is still parked
+// when the plugin unloads, and the OS cleans up after both.
+inline Pool& pool() {
+    static Pool* pool = new Pool();
+    return *pool;
+}
+
 } // Javascript
@@ -13,7 +13,9 @@
   0. You just DO WHAT THE FUCK YOU WANT TO.
 */
 #pragma once
-#include "plugin.hpp"
+#include <rack.hpp>
+
+using namespace rack;
 
 // Implements the Portable Sequences interchange format: 
 // https://github.com/squinkylabs/SquinkyVCV/blob/master/docs/clipboard-format.md
@@ -13,6 +13,8 @@
   0. You just DO WHAT THE FUCK YOU WANT TO.
 */
 #pragma once
+#include <cstring>
+#include <emmintrin.h>
 
 // Deterministic seedable PRNG
 // Using xoroshiro128+ like VCV does - gives me a better distribution than mersenne twister.
@@ -23,8 +25,29 @@
 //
 // Running an automated test on Darius, I'm obtaining a distribution of results that look sane, 
 // not skewed to either side, which was a problem with std's mersenne twister.
+// The route simulator in `make test` keeps checking that.
+//
+// Seeds go through splitmix64 like the authors recommend, so there's no need to warm up anymore
+// and every draw is a single step. The old way of seeding, and the 50 dry runs before every draw,
+// are still there with `legacy`: Darius patches made before need them to take the same routes.
 namespace prng {
 
+// Turns any 64 bit key into well mixed state, even 0 or keys that only differ by a bit
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// The exact bits of two floats as one key, e.g. a seed voltage
+inline uint64_t keyOf(float seed1, float seed2) {
+    uint32_t bits1, bits2;
+    std::memcpy(&bits1, &seed1, sizeof(bits1));
+    std::memcpy(&bits2, &seed2, sizeof(bits2));
+    return ((uint64_t) bits1 << 32) | bits2;
+}
+
 struct prng {
 
     inline uint64_t rotl(const uint64_t x, int k) {
@@ -32,6 +55,7 @@ struct prng {
     }
 
     uint64_t s[2];
+    bool legacy = false;
 
     uint64_t next(void) {
         const uint64_t s0 = s[0];
@@ -44,18 +68,155 @@ struct prng {
 
         return result;
     }
-    
+
+    void seed(uint64_t key) {
+        s[0] = splitmix64(key);
+        s[1] = splitmix64(key);
+    }
+
+    // Seeds from the exact bits of two floats, e.g. a seed voltage
     void init(float seed1, float seed2){
-        s[0] = seed1 * 572376460694501; // Keyboard smash - salting seems to improve results
-        s[1] = seed2 * 645624357248923;
-        for (int i = 0; i < 50; i++) next(); // Warm up for better results
+        if (legacy) {
+            s[0] = seed1 * 572376460694501; // Keyboard smash - salting seems to improve results
+            s[1] = seed2 * 645624357248923;
+            for (int i = 0; i < 50; i++) next(); // Warm up for better results
+        } else {
+            seed(keyOf(seed1, seed2));
+        }
+    }
+
+    // Same as 2^64 calls to next(): splits one seed into 2^64 streams that never overlap,
+    // e.g. one per channel.
+    void jump() {
+        static const uint64_t JUMP[] = { 0xdf900294d8f554a5, 0x170865df4b3201fc };
+        jump(JUMP);
     }
 
+    // Same as 2^96 calls to next(): 2^32 groups of streams that never overlap, e.g. one per instance,
+    // each of which can still be split further with jump().
+    void long_jump() {
+        static const uint64_t LONG_JUMP[] = { 0xd2a98b26625eee7b, 0xdddf9b1090aa7ac1 };
+        jump(LONG_JUMP);
+    }
+
+    void jump(const uint64_t* polynomial) {
+        uint64_t s0 = 0;
+        uint64_t s1 = 0;
+        for (int i = 0; i < 2; i++) {
+            for (int b = 0; b < 64; b++) {
+                if (polynomial[i] & UINT64_C(1) << b) {
+                    s0 ^= s[0];
+                    s1 ^= s[1];
+                }
+                next();
+            }
+        }
+        s[0] = s0;
+        s[1] = s1;
+    }
+
+    // From 0 to 1, in steps of 2^-24
     float uniform() {
-        for (int i = 0; i < 50; i++) next(); // More dry runs.
-        return (next() >> (64 - 24)) / std::pow(2.f, 24);
+        if (legacy) {
+            for (int i = 0; i < 50; i++) next(); // More dry runs.
+        }
+        return (next() >> (64 - 24)) * (1.f / 16777216.f);
+    }
+
+    void fill(float* out, int count) {
+        for (int i = 0; i < count; i++) out[i] = uniform();
+    }
+
+    // One of the set bits of a mask, all equally likely, in a single draw and without building a list to shuffle.
+    // The mask can't be empty.
+    int pickBit(uint32_t mask) {
+        uint32_t nth = ((next() >> 32) * __builtin_popcount(mask)) >> 32;
+        for (uint32_t i = 0; i < nth; i++) mask &= mask - 1; // Drop the lowest one
+        return __builtin_ctz(mask);
     }
 
 };
 
+
+// Several generators stepping side by side, two per SSE register, for drawing blocks of randomness
+// at control rate and using them up one event at a time.
+// Lane 0 is a prng seeded with the same key, and every lane after that is the previous one after a jump(),
+// so the lanes never overlap. No legacy mode: nothing old depends on this one.
+//
+// SSE2 has 64 bit adds, shifts and xors, that's all xoroshiro128+ needs. 8 lanes is usually faster than 4
+// even though it's the same instructions, since the two halves don't wait on each other.
+template <int LANES>
+struct simdPrng {
+    static_assert(LANES % 4 == 0, "Lanes come by float_4");
+    static const int PAIRS = LANES / 2;
+
+    __m128i s0[PAIRS];
+    __m128i s1[PAIRS];
+
+    template <int K>
+    static __m128i rotl(__m128i x) {
+        return _mm_or_si128(_mm_slli_epi64(x, K), _mm_srli_epi64(x, 64 - K));
+    }
+
+    void seed(uint64_t key) {
+        prng lane;
+        lane.seed(key);
+        for (int i = 0; i < PAIRS; i++) {
+            uint64_t first[2] = {lane.s[0], lane.s[1]};
+            lane.jump();
+            uint64_t second[2] = {lane.s[0], lane.s[1]};
+            lane.jump();
+            s0[i] = _mm_set_epi64x(second[0], first[0]);
+            s1[i] = _mm_set_epi64x(second[1], first[1]);
+        }
+    }
+
+    void init(float seed1, float seed2) {
+        seed(keyOf(seed1, seed2));
+    }
+
+    // One step of every lane, same as prng::next()
+    void next(__m128i* results) {
+        for (int i = 0; i < PAIRS; i++) {
+            __m128i a = s0[i];
+            __m128i b = s1[i];
+            results[i] = _mm_add_epi64(a, b);
+
+            b = _mm_xor_si128(b, a);
+            s0[i] = _mm_xor_si128(_mm_xor_si128(rotl<24>(a), b), _mm_slli_epi64(b, 16)); // a, b
+            s1[i] = rotl<37>(b); // c
+        }
+    }
+
+    // One draw per lane, from 0 to 1 in steps of 2^-24 like prng::uniform()
+    void uniform(simd::float_4* out) {
+        __m128i results[PAIRS];
+        next(results);
+        for (int i = 0; i < LANES / 4; i++) {
+            // Top 24 bits of each lane, then the low halves of both registers packed into one
+            __m128 low = _mm_castsi128_ps(_mm_srli_epi64(results[2 * i], 64 - 24));
+            __m128 high = _mm_castsi128_ps(_mm_srli_epi64(results[2 * i + 1], 64 - 24));
+            __m128i packed = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+            out[i] = simd::float_4(_mm_cvtepi32_ps(packed)) * (1.f / 16777216.f);
+        }
+    }
+
+    // out[i] comes from lane i % LANES. If count isn't a multiple of LANES, the draws past it are thrown away.
+    void fill(float* out, int count) {
+        simd::float_4 block[LANES / 4];
+        int i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            uniform(block);
+            for (int j = 0; j < LANES / 4; j++) block[j].store(out + i + 4 * j);
+        }
+        if (i < count) {
+            uniform(block);
+            std::memcpy(out + i, block, (count - i) * sizeof(float));
+        }
+    }
+};
+
+typedef simdPrng<4> prng4;
+typedef simdPrng<8> prng8;
+
 }
@@ -0,0 +1,224 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <initializer_list>
+
+#ifdef ARIA_PROFILER
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace rack;
+
+// Opt-in profiler, to find out which module is eating the CPU budget in a big patch.
+// Off by default and compiled out entirely. Build with `make PROFILER=1` to turn it on.
+//
+// A module declares its sections, and times them with PROFILE_SCOPE until the end of the block:
+//     enum ProfileIds { PROFILE_PROCESS, PROFILE_UPDATE_LCD, NUM_PROFILES };
+//     Profiler::Profile profile {"process", "updateLcd"};
+//     void process(const ProcessArgs& args) override { PROFILE_SCOPE(profile, PROFILE_PROCESS); ... }
+//
+// Results show in the context menu, and can be dumped as JSON in the user folder.
+// The audio thread writes the histograms while the UI reads them without locking,
+// so the numbers can be off by a sample or two. Doesn't matter for this purpose.
+namespace Profiler {
+
+#ifdef ARIA_PROFILER
+
+// The cheapest clock available: the TSC on x86, nanoseconds elsewhere.
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t now() {
+    return __rdtsc();
+}
+const char* const UNIT = "cycles";
+#else
+inline uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+const char* const UNIT = "ns";
+#endif
+
+
+// Log-scale histogram with 4 buckets per power of two, so percentiles are within 25%.
+// Recording a duration is a few instructions and never allocates.
+struct Histogram {
+    static const int BUCKETS = 256;
+    uint32_t buckets[BUCKETS] = {};
+    uint64_t count = 0;
+    uint64_t max = 0;
+
+    static int bucketOf(uint64_t duration) {
+        if (duration < 4) return duration;
+        int log = 63 - __builtin_clzll(duration);
+        return log * 4 + ((duration >> (log - 2)) & 3);
+    }
+
+    // The largest duration that falls in a bucket
+    static uint64_t upperBoundOf(int bucket) {
+        if (bucket < 4) return bucket;
+        int log = bucket / 4;
+        return ((uint64_t) (5 + bucket % 4) << (log - 2)) - 1;
+    }
+
+    void add(uint64_t duration) {
+        buckets[bucketOf(duration)]++;
+        count++;
+        if (duration > max) max = duration;
+    }
+
+    // Percentile from 0 to 1
+    uint64_t percentile(float p) const {
+        if (count == 0) return 0;
+        uint64_t target = std::max((uint64_t) 1, (uint64_t) std::ceil(p * count));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= target) return std::min(upperBoundOf(i), max);
+        }
+        return max;
+    }
+
+    void reset() {
+        for (int i = 0; i < BUCKETS; i++) buckets[i] = 0;
+        count = 0;
+        max = 0;
+    }
+};
+
+
+struct Section {
+    std::string name;
+    Histogram histogram;
+};
+
+
+struct Profile {
+    std::vector<Section> sections;
+
+    Profile(std::initializer_list<std::string> names) {
+        for (const std::string& name : names) {
+            Section section;
+            section.name = name;
+            sections.push_back(section);
+        }
+    }
+
+    void reset() {
+        for (Section& section : sections) section.histogram.reset();
+    }
+
+    std::string summary(const Section& section) const {
+        return string::f("%s: p50 %llu p99 %llu max %llu %s",
+            section.name.c_str(),
+            (unsigned long long) section.histogram.percentile(0.5f),
+            (unsigned long long) section.histogram.percentile(0.99f),
+            (unsigned long long) section.histogram.max,
+            UNIT);
+    }
+
+    json_t* toJson() const {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "unit", json_string(UNIT));
+        json_t* sectionsJ = json_object();
+        for (const Section& section : sections) {
+            json_t* sectionJ = json_object();
+            json_object_set_new(sectionJ, "count", json_integer(section.histogram.count));
+            json_object_set_new(sectionJ, "p50", json_integer(section.histogram.percentile(0.5f)));
+            json_object_set_new(sectionJ, "p99", json_integer(section.histogram.percentile(0.99f)));
+            json_object_set_new(sectionJ, "max", json_integer(section.histogram.max));
+            json_object_set_new(sectionsJ, section.name.c_str(), sectionJ);
+        }
+        json_object_set_new(rootJ, "sections", sectionsJ);
+        return rootJ;
+    }
+
+    // Writes to AriaSalvatrice/profile-<slug>-<module id>.json in the user folder
+    void dump(Module* module) const {
+        system::createDirectory(asset::user("AriaSalvatrice"));
+        std::string filename = asset::user("AriaSalvatrice/profile-") + module->model->slug + "-" + std::to_string(module->id) + ".json";
+        json_t* rootJ = toJson();
+        json_object_set_new(rootJ, "module", json_string(module->model->slug.c_str()));
+        json_object_set_new(rootJ, "id", json_integer(module->id));
+        json_dump_file(rootJ, filename.c_str(), JSON_INDENT(2));
+        json_decref(rootJ);
+    }
+};
+
+
+// Times until the end of the block
+struct Scope {
+    Histogram& histogram;
+    uint64_t start;
+
+    Scope(Profile& profile, int section) : histogram(profile.sections[section].histogram), start(now()) {}
+
+    ~Scope() {
+        histogram.add(now() - start);
+    }
+};
+
+#define PROFILE_SCOPE(profile, section) Profiler::Scope profilerScope##section(profile, section)
+
+
+struct DumpItem : MenuItem {
+    Module* module;
+    Profile* profile;
+    void onAction(const event::Action &e) override {
+        profile->dump(module);
+    }
+};
+
+struct ResetItem : MenuItem {
+    Profile* profile;
+    void onAction(const event::Action &e) override {
+        profile->reset();
+    }
+};
+
+#else
+
+// Compiled out: nothing to store and nothing to time.
+struct Profile {
+    Profile(std::initializer_list<std::string> names) {}
+};
+
+#define PROFILE_SCOPE(profile, section)
+
+#endif
+
+
+// Shows the results at the bottom of the context menu. Does nothing unless the profiler is enabled.
+inline void appendContextMenu(ui::Menu* menu, Module* module, Profile& profile) {
+#ifdef ARIA_PROFILER
+    menu->addChild(new MenuSeparator());
+    menu->addChild(createMenuLabel<MenuLabel>("Profiler"));
+    for (const Section& section : profile.sections) {
+        menu->addChild(createMenuLabel<MenuLabel>(profile.summary(section)));
+    }
+
+    DumpItem* dumpItem = createMenuItem<DumpItem>("Dump profile to JSON");
+    dumpItem->module = module;
+    dumpItem->profile = &profile;
+    menu->addChild(dumpItem);
+
+    ResetItem* resetItem = createMenuItem<ResetItem>("Reset profile");
+    resetItem->profile = &profile;
+    menu->addChild(resetItem);
+#endif
+}
+
+} // Profiler
@@ -22,6 +22,62 @@ namespace Quantizer {
 const float FUDGEOFFSET = 0.001f;
 
 
+// The valid notes of a scale as a 12-bit mask, bit 0 being C. 12TET only.
+// Reads like a bool[12], but copying and comparing it is a single integer operation.
+struct ScaleMask {
+    uint16_t bits = 0;
+
+    constexpr ScaleMask() {}
+
+    constexpr explicit ScaleMask(uint16_t bits) : bits(bits & 0xfff) {}
+
+    explicit ScaleMask(const std::array<bool, 12>& notes) {
+        for (int i = 0; i < 12; i++) set(i, notes[i]);
+    }
+
+    constexpr bool operator[](int note) const {
+        return (bits >> note) & 1;
+    }
+
+    constexpr bool operator==(const ScaleMask& other) const {
+        return bits == other.bits;
+    }
+
+    constexpr bool operator!=(const ScaleMask& other) const {
+        return bits != other.bits;
+    }
+
+    void set(int note, bool valid = true) {
+        if (valid) {
+            bits |= 1 << note;
+        } else {
+            bits &= ~(1 << note);
+        }
+    }
+
+    constexpr bool empty() const {
+        return bits == 0;
+    }
+
+    // Amount of valid notes
+    int count() const {
+        return __builtin_popcount(bits);
+    }
+
+    // The same scale moved to another key, C being 0
+    constexpr ScaleMask rotated(int key) const {
+        return ScaleMask((uint16_t) ((bits << key) | (bits >> (12 - key))));
+    }
+
+    // For the LCD piano display
+    std::array<bool, 12> toArray() const {
+        std::array<bool, 12> notes;
+        for (int i = 0; i < 12; i++) notes[i] = (*this)[i];
+        return notes;
+    }
+};
+
+
 // Except for Major/natural minor & pentatonic scales, I avoided scales that are modes of another.
 // I wanted a curation limited to interesting instant satisfaction presets that
 // work well with generative patterns and sound good to average modern western ears.
@@ -100,82 +156,91 @@ inline std::string scaleLcdName(const int& scale){
 }
 
 
+// The individual notes of each scale from the ScalesEnum, in the key of C, in the same order.
+constexpr bool SCALE_NOTES[NUM_SCALES][12] = {
+    {true,  true,  true,  true,  true,  true,  true,  true,  true,  true,  true,  true}, // CHROMATIC
+    {true, false,  true, false,  true,  true, false,  true, false,  true, false,  true}, // MAJOR
+    {true, false,  true,  true, false,  true, false,  true,  true, false,  true, false}, // NATURAL_MINOR
+    {true, false,  true,  true, false,  true, false,  true, false,  true, false,  true}, // MELODIC_MINOR
+    {true, false,  true,  true, false,  true, false,  true,  true, false, false,  true}, // HARMONIC_MINOR
+    {true, false,  true, false,  true, false, false,  true, false,  true, false, false}, // PENTATONIC_MAJOR
+    {true, false, false,  true, false,  true, false,  true, false, false,  true, false}, // PENTATONIC_MINOR
+    {true, false,  true, false,  true, false,  true, false,  true, false,  true, false}, // WHOLE_TONE
+    {true, false,  true,  true,  true, false, false,  true, false,  true, false, false}, // BLUES_MAJOR
+    {true, false, false,  true, false,  true,  true,  true, false, false,  true, false}, // BLUES_MINOR
+    {true,  true, false,  true,  true, false,  true,  true, false,  true,  true, false}, // DOMINANT_DIMINISHED
+    {true, false,  true, false,  true,  true, false,  true,  true,  true, false,  true}, // BEBOP_MAJOR
+    {true, false,  true,  true,  true,  true, false,  true, false,  true,  true, false}, // BEBOP_MINOR
+    {true,  true, false, false,  true,  true, false,  true,  true, false, false,  true}, // DOUBLE_HARMONIC
+    {true,  true, false,  true,  true,  true,  true, false,  true, false,  true, false}, // EIGHT_TONE_SPANISH
+    {true,  true, false, false, false,  true,  true, false, false, false,  true, false}, // HIRAJOSHI
+    {true,  true, false, false, false,  true, false,  true, false, false,  true, false}, // IN_SEN
+};
+
+
+namespace ScaleTable {
+
+// Indices 0 to N-1 as a template parameter pack, to generate the table at compile time.
+template <int... I> struct Indices {};
+template <int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+constexpr int maskOfScale(int scale, int note = 11) {
+    return (note < 0) ? 0 : (SCALE_NOTES[scale][note] << note) | maskOfScale(scale, note - 1);
+}
+
+struct Table {
+    ScaleMask masks[NUM_SCALES * 12];
+};
+
+// Entry scale * 12 + key
+template <int... I>
+constexpr Table make(Indices<I...>) {
+    return Table {{ ScaleMask((uint16_t) maskOfScale(I / 12)).rotated(I % 12)... }};
+}
+
+} // ScaleTable
+
+
+// Every scale in every key, built by the compiler. Looking up a scale is a single load.
+constexpr ScaleTable::Table SCALE_KEY_TABLE = ScaleTable::make(ScaleTable::MakeIndices<NUM_SCALES * 12>::type());
+
+
 // The individual notes of the corresponding scale from the ScalesEnum, in the key of C
-inline std::array<bool, 12> validNotesInScale(const int& scale){
-    switch(scale){
-        case CHROMATIC: {
-            std::array<bool, 12> s {true,  true,  true,  true,  true,  true,  true,  true,  true,  true,  true,  true};
-            return s;
-        }
-        case MAJOR: {
-            std::array<bool, 12> s {true, false,  true, false,  true,  true, false,  true, false,  true, false,  true};
-            return s;
-        }
-        case NATURAL_MINOR: {
-            std::array<bool, 12> s {true, false,  true,  true, false,  true, false,  true,  true, false,  true, false};
-            return s;
-        }
-        case MELODIC_MINOR: {
-            std::array<bool, 12> s {true, false,  true,  true, false,  true, false,  true, false,  true, false,  true};
-            return s;
-        }
-        case HARMONIC_MINOR: {
-            std::array<bool, 12> s {true, false,  true,  true, false,  true, false,  true,  true, false, false,  true};
-            return s;
-        }
-        case PENTATONIC_MAJOR: {
-            std::array<bool, 12> s {true, false,  true, false,  true, false, false,  true, false,  true, false, false};
-            return s;
-        }
-        case PENTATONIC_MINOR: {
-            std::array<bool, 12> s {true, false, false,  true, false,  true, false,  true, false, false,  true, false};
-            return s;
-        }
-        case WHOLE_TONE: {
-            std::array<bool, 12> s {true, false,  true, false,  true, false,  true, false,  true, false,  true, false};
-            return s;
-        }
-        case BLUES_MAJOR: {
-            std::array<bool, 12> s {true, false,  true,  true,  true, false, false,  true, false,  true, false, false};
-            return s;
-        }
-        case BLUES_MINOR: {
-            std::array<bool, 12> s {true, false, false,  true, false,  true,  true,  true, false, false,  true, false};
-            return s;
-        }
-        case DOMINANT_DIMINISHED: {
-            std::array<bool, 12> s {true,  true, false,  true,  true, false,  true,  true, false,  true,  true, false};
-            return s;
-        }
-        case BEBOP_MAJOR: {
-            std::array<bool, 12> s {true, false,  true, false,  true,  true, false,  true,  true,  true, false,  true};
-            return s;
-        }
-        case BEBOP_MINOR: {
-            std::array<bool, 12> s {true, false,  true,  true,  true,  true, false,  true, false,  true,  true, false};
-            return s;
-        }
-        case DOUBLE_HARMONIC: {
-            std::array<bool, 12> s {true,  true, false, false,  true,  true, false,  true,  true, false, false,  true};
-            return s;
-        }
-        case EIGHT_TONE_SPANISH: {
-            std::array<bool, 12> s {true,  true, false,  true,  true,  true,  true, false,  true, false,  true, false};
-            return s;
-        }
-        case HIRAJOSHI: {
-            std::array<bool, 12> s {true,  true, false, false, false,  true,  true, false, false, false,  true, false};
-            return s;
-        }
-        case IN_SEN: {
-            std::array<bool, 12> s {true,  true, false, false, false,  true, false,  true, false, false,  true, false};
-            return s;
-        }
-    }
-    std::array<bool, 12> none     {false, false, false, false, false, false, false, false, false, false, false, false};
-    return none;
+constexpr ScaleMask validNotesInScale(int scale){
+    return (scale >= 0 && scale < NUM_SCALES) ? SCALE_KEY_TABLE.masks[scale * 12] : ScaleMask();
+}
+
+
+// The individual notes of the corresponding scale from the ScalesEnum, in the specified key
+constexpr ScaleMask validNotesInScaleKey(int scale, int key){
+    return (scale >= 0 && scale < NUM_SCALES && key >= 0 && key < 12) ? SCALE_KEY_TABLE.masks[scale * 12 + key] : ScaleMask();
+}
+
+
+namespace ScaleTable {
+
+// Transposing to a key moves note n of the scale in C to note n + key.
+constexpr bool entryIsValid(int entry, int note = 0) {
+    return (note >= 12) or (SCALE_KEY_TABLE.masks[entry][note] == SCALE_NOTES[entry / 12][(note + 12 - entry % 12) % 12]
+        and entryIsValid(entry, note + 1));
 }
 
+// Split in halves so the recursion stays shallow enough for the compiler
+constexpr bool entriesAreValid(int from, int to) {
+    return (to - from == 1) ? entryIsValid(from) : entriesAreValid(from, (from + to) / 2) and entriesAreValid((from + to) / 2, to);
+}
+
+static_assert(entriesAreValid(0, NUM_SCALES * 12), "Scale table doesn't match the scale definitions");
+static_assert(validNotesInScale(CHROMATIC) == ScaleMask(0xfff), "Chromatic should have every note");
+static_assert(validNotesInScaleKey(MAJOR, 0) == ScaleMask(0xab5), "C major should be C D E F G A B");
+static_assert(validNotesInScaleKey(MAJOR, 7) == ScaleMask(0xad5), "G major should be G A B C D E F#");
+static_assert(validNotesInScaleKey(NATURAL_MINOR, 9) == validNotesInScale(MAJOR), "A minor should be C major");
+static_assert(validNotesInScaleKey(WHOLE_TONE, 2) == validNotesInScale(WHOLE_TONE), "Whole tone should repeat every 2 semitones");
+static_assert(validNotesInScale(NUM_SCALES).empty(), "Unknown scales should have no notes");
+
+} // ScaleTable
+
 
 // The note/key name, two characters, sharp notation.
 inline std::string keyLcdName(const int& key){
@@ -217,28 +282,16 @@ inline std::string keySegmentName(const int& key){
     return "";
 }
 
-// The individual notes of the corresponding scale from the ScalesEnum, in the specified key
-inline std::array<bool, 12> validNotesInScaleKey(const int& scale, const int& key){
-    std::array<bool, 12> notes = validNotesInScale(scale);
-    std::rotate(notes.rbegin(), notes.rbegin() + key, notes.rend());
-    return notes;
-}
-
-
-// Quantizes the voltage to the scale, expressed as a bool[12] starting on C. 12TET only.
-// After quantizing, can optionally transpose up or down by scale degrees
-inline float quantize(float voltage, const std::array<bool, 12>& validNotes, int transposeSd = 0) {
-
-    voltage = voltage + FUDGEOFFSET;
-
-    float octave = floorf(voltage);
-    float voltageOnFirstOctave = voltage - octave;
+// Seeks the valid note closest to a voltage within the first octave, also considering
+// the first valid note one octave up. Ties go to the lowest note.
+// Returns the note number and sets closestNoteFound to its voltage, or returns -1 when there's no valid notes.
+inline int closestNoteInOctave(float voltageOnFirstOctave, const ScaleMask& validNotes, float& closestNoteFound) {
     float currentComparison;
     float currentDistance;
-    float closestNoteFound = 10.0;
     float closestNoteDistance = 10.0;
-    int closestNoteFoundNum = 0;
-    
+    int closestNoteFoundNum = -1;
+    closestNoteFound = 10.0;
+
     // Iterate notes and seek the closest match
     for (int note = 0; note < 12; note++) {
         if (validNotes[note]) {
@@ -264,33 +317,62 @@ inline float quantize(float voltage, const std::array<bool, 12>& validNotes, int
             break;
         }
     }
+    return closestNoteFoundNum;
+}
+
+
+// Where each note sits in the scale and the other way around, to transpose by any amount of
+// scale degrees in one go instead of walking semitone by semitone.
+struct Degrees {
+    int count = 0;
+    int8_t degreeOfNote[12]; // -1 when the note isn't in the scale
+    int8_t noteOfDegree[12];
 
-    if (closestNoteDistance < 10.0) {
+    void build(const ScaleMask& validNotes) {
+        count = 0;
+        for (int note = 0; note < 12; note++) {
+            if (validNotes[note]) {
+                degreeOfNote[note] = count;
+                noteOfDegree[count] = note;
+                count++;
+            } else {
+                degreeOfNote[note] = -1;
+            }
+        }
+    }
+
+    // Transposes a note of the scale, starting from the octave it's in.
+    float transpose(float noteOctave, int note, int transposeSd) const {
+        // Keep it to a sane range just in case
+        transposeSd = clamp(transposeSd, -120, 120); 
+        int degree = degreeOfNote[note] + transposeSd;
+        // Rounds towards negative infinity, since we can go down
+        int octaves = (degree >= 0) ? degree / count : - ((count - 1 - degree) / count);
+        degree -= octaves * count;
+        return noteOctave + octaves + noteOfDegree[degree] / 12.f;
+    }
+};
+
+
+// Quantizes the voltage to the scale, expressed as a ScaleMask. 12TET only.
+// After quantizing, can optionally transpose up or down by scale degrees
+// For anything running at audio rates, use an Engine instead.
+inline float quantize(float voltage, const ScaleMask& validNotes, int transposeSd = 0) {
+
+    voltage = voltage + FUDGEOFFSET;
+
+    float octave = floorf(voltage);
+    float closestNoteFound;
+    int closestNoteFoundNum = closestNoteInOctave(voltage - octave, validNotes, closestNoteFound);
+
+    if (closestNoteFoundNum >= 0) {
         // We found a match
         voltage = octave + closestNoteFound;
         // Transpose it by scale degrees if requested
         if (transposeSd != 0) {
-            // Keep it to a sane range just in case
-            transposeSd = clamp(transposeSd, -120, 120); 
-            if (transposeSd > 0) {
-                // Add scale degrees
-                for (int i = 0; i < transposeSd;) {
-                    voltage += 1.f / 12.f;
-                    closestNoteFoundNum++;
-                    if (closestNoteFoundNum == 12) closestNoteFoundNum = 0;
-                    // Because we found a match earlier we know there are some validNotes,
-                    // so the loop should never get stuck.
-                    if (validNotes[closestNoteFoundNum]) i++;
-                }
-            } else {
-                // Subtract scale degrees
-                for (int i = 0; i < abs(transposeSd);) {
-                    voltage -= 1.f / 12.f;
-                    closestNoteFoundNum--;
-                    if (closestNoteFoundNum == -1) closestNoteFoundNum = 11;
-                    if (validNotes[closestNoteFoundNum]) i++;
-                }
-            }
+            Degrees degrees;
+            degrees.build(validNotes);
+            voltage = degrees.transpose((closestNoteFound >= 1.f) ? octave + 1.f : octave, closestNoteFoundNum, transposeSd);
         }
     } else {
         // Pass output as-is when no match found (happens when there's no valid notes)
@@ -298,8 +380,130 @@ inline float quantize(float voltage, const std::array<bool, 12>& validNotes, int
     return clamp(voltage, -10.f, 10.f);
 }
 
+
+// Same results as quantize(), bit for bit, but with the work done ahead of time for one scale.
+// The table is only rebuilt when the scale mask actually changes, so it's fine to call setScale() often.
+//
+// The decision boundary between two neighbouring notes always falls on a half-semitone, so the octave
+// is split in 25 bins centered on each of them. A bin holds at most one boundary, found by bisecting
+// closestNoteInOctave() itself, which guarantees floating point rounding matches the reference exactly.
+// Quantizing is then a floor, a lookup, and a compare.
+struct Engine {
+    static const int BINS = 25;
+
+    ScaleMask validNotes;
+    bool built = false;
+    bool empty = true;
+    float threshold[BINS];
+    float below[BINS];
+    float above[BINS];
+    int8_t belowNote[BINS];
+    int8_t aboveNote[BINS];
+    Degrees degrees;
+
+    Engine() {
+        setScale(validNotesInScale(CHROMATIC));
+    }
+
+    void setScale(const ScaleMask& notes) {
+        if (built && notes == validNotes) return;
+        validNotes = notes;
+        build();
+    }
+
+    void build() {
+        built = true;
+        empty = validNotes.empty();
+        if (empty) return;
+        degrees.build(validNotes);
+        for (int bin = 0; bin < BINS; bin++) {
+            // Bin edges, kept inside the bin and within the range the reference handles
+            float low = std::max((bin - 0.5f) / 24.f, 0.f);
+            float high = std::nextafter((bin + 0.5f) / 24.f, 0.f);
+            float lowFound, highFound;
+            belowNote[bin] = closestNoteInOctave(low, validNotes, lowFound);
+            aboveNote[bin] = closestNoteInOctave(high, validNotes, highFound);
+            below[bin] = lowFound;
+            above[bin] = highFound;
+            if (lowFound == highFound) {
+                threshold[bin] = INFINITY;
+                continue;
+            }
+            // Seek the smallest voltage that picks the upper note. Positive floats sort like their bits.
+            uint32_t lowBits, highBits, midBits;
+            std::memcpy(&lowBits, &low, sizeof(float));
+            std::memcpy(&highBits, &high, sizeof(float));
+            while (highBits - lowBits > 1) {
+                midBits = lowBits + (highBits - lowBits) / 2;
+                float mid, midFound;
+                std::memcpy(&mid, &midBits, sizeof(float));
+                closestNoteInOctave(mid, validNotes, midFound);
+                if (midFound == highFound) {
+                    highBits = midBits;
+                } else {
+                    lowBits = midBits;
+                }
+            }
+            std::memcpy(&threshold[bin], &highBits, sizeof(float));
+        }
+    }
+
+    float quantize(float voltage, int transposeSd = 0) const {
+        voltage = voltage + FUDGEOFFSET;
+        // Pass output as-is when there's no valid notes
+        if (empty) return clamp(voltage, -10.f, 10.f);
+
+        float octave = floorf(voltage);
+        float voltageOnFirstOctave = voltage - octave;
+        int bin = clamp((int) (voltageOnFirstOctave * 24.f + 0.5f), 0, BINS - 1);
+        bool up = (voltageOnFirstOctave >= threshold[bin]);
+        float closestNoteFound = up ? above[bin] : below[bin];
+        if (transposeSd != 0) {
+            voltage = degrees.transpose((closestNoteFound >= 1.f) ? octave + 1.f : octave, up ? aboveNote[bin] : belowNote[bin], transposeSd);
+        } else {
+            voltage = octave + closestNoteFound;
+        }
+        return clamp(voltage, -10.f, 10.f);
+    }
+
+    // Four voltages at once. Only the table lookups are done lane by lane, picking the note is branchless.
+    simd::float_4 quantize(simd::float_4 voltage, int transposeSd = 0) const {
+        voltage += FUDGEOFFSET;
+        if (empty) return simd::clamp(voltage, -10.f, 10.f);
+
+        simd::float_4 octave = simd::floor(voltage);
+        simd::float_4 voltageOnFirstOctave = voltage - octave;
+        simd::float_4 binVoltage = voltageOnFirstOctave * 24.f + 0.5f;
+        simd::float_4 laneThreshold, laneBelow, laneAbove;
+        int bin[4];
+        for (int i = 0; i < 4; i++) {
+            bin[i] = clamp((int) binVoltage[i], 0, BINS - 1);
+            laneThreshold[i] = threshold[bin[i]];
+            laneBelow[i] = below[bin[i]];
+            laneAbove[i] = above[bin[i]];
+        }
+        simd::float_4 up = (voltageOnFirstOctave >= laneThreshold);
+        voltage = octave + simd::ifelse(up, laneAbove, laneBelow);
+        if (transposeSd != 0) {
+            for (int i = 0; i < 4; i++) {
+                bool laneUp = (voltageOnFirstOctave[i] >= laneThreshold[i]);
+                float noteOctave = (laneUp ? laneAbove[i] : laneBelow[i]) >= 1.f ? octave[i] + 1.f : octave[i];
+                voltage[i] = degrees.transpose(noteOctave, laneUp ? aboveNote[bin[i]] : belowNote[bin[i]], transposeSd);
+            }
+        }
+        return simd::clamp(voltage, -10.f, 10.f);
+    }
+
+    // Quantizes up to 16 channels, four at a time. Both arrays must have room for 16 voltages, and can be the same.
+    void quantizeBlock(const float* in, float* out, int channels, int transposeSd = 0) const {
+        for (int c = 0; c < channels; c += 4) {
+            quantize(simd::float_4::load(in + c), transposeSd).store(out + c);
+        }
+    }
+};
+
 // C3 = 0, C#5 = 1, D8 = 2, etc.
-inline int quantizeToPositionInOctave(float voltage, const std::array<bool, 12>& validNotes) {
+inline int quantizeToPositionInOctave(float voltage, const ScaleMask& validNotes) {
     voltage = quantize(voltage, validNotes);
     voltage = voltage * 12.f + 60.f;
     return (int) voltage % 12;
@@ -335,12 +539,8 @@ inline std::array<bool, 12> pianoDisplay(float voltage) {
     return notes;
 }
 
-inline size_t scaleDegreeCountInScale(std::array<bool, 12> scale) {
-    size_t count = 0;
-    for (size_t i = 0; i < 12; i++) {
-        if (scale[i]) count++;
-    }
-    return count;
+inline size_t scaleDegreeCountInScale(const ScaleMask& scale) {
+    return scale.count();
 }
 
 } // namespace Quantizer
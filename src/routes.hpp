@@ -0,0 +1,231 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// The triangle of nodes Darius routes through, for any number of steps.
+//
+// Nodes are numbered layer by layer from the top, so a bigger triangle starts with the exact same
+// numbering as a smaller one, and an 8-step patch means the same thing on a 16-step tree:
+//
+//   step 1:         0
+//   step 2:       2   1
+//   step 3:     5   4   3
+//   ...
+//
+// Every node but those on the last step has a route knob, the chance to go down instead of up.
+namespace Routes {
+
+template <int STEPS>
+struct Triangle {
+    static const int NODES = STEPS * (STEPS + 1) / 2;
+
+    // The first node of a step, counting steps from 0
+    static constexpr int stepStart(int step) {
+        return step * (step + 1) / 2;
+    }
+
+    // Which step each node is on
+    struct Layout {
+        int stepOf[NODES];
+        Layout() {
+            for (int step = 0; step < STEPS; step++) {
+                for (int node = stepStart(step); node < stepStart(step + 1); node++) stepOf[node] = step;
+            }
+        }
+    };
+
+    static const Layout& layout() {
+        static const Layout layout;
+        return layout;
+    }
+
+    static int stepOf(int node) {
+        return layout().stepOf[node];
+    }
+
+    // 0 on the last step, where there's nowhere to go
+    static int upChild(int node) {
+        int step = stepOf(node);
+        return (step < STEPS - 1) ? node + step + 1 : 0;
+    }
+
+    static int downChild(int node) {
+        int up = upChild(node);
+        return up ? up + 1 : 0;
+    }
+
+    // Where a path goes when entering `step` from `node`, given a draw from 0 to 1.
+    // The route is the chance to go down.
+    static int next(int node, int step, float route, float draw) {
+        return (draw < route) ? node + step + 1 : node + step;
+    }
+
+    // A whole path from the top, drawing from anything with a uniform() like prng::prng
+    template <typename TPrng>
+    static void walk(const float* routes, TPrng& prng, int* path) {
+        path[0] = 0;
+        for (int step = 1; step < STEPS; step++) path[step] = next(path[step - 1], step, routes[path[step - 1]], prng.uniform());
+    }
+
+    // stoermelder's binary tree: the paths split in two on steps 0, 2, 6, 14..., and in between
+    // they spread apart, so that the next split fills the whole step below it with equal chances.
+    // Path i of `paths` has `paths - 1` steps to get from node i to node 2i of its step,
+    // going down as evenly as it can. Nodes no path goes through are left in the center.
+    static void binaryTree(float* routes) {
+        for (int i = 0; i < NODES; i++) routes[i] = 0.5f;
+        for (int paths = 2; paths < STEPS; paths *= 2) {
+            int moves = paths - 1;
+            for (int move = 0; move < moves and paths - 1 + move < STEPS - 1; move++) {
+                int step = paths - 1 + move;
+                for (int i = 0; i < paths; i++) {
+                    int down = spread(i, move, moves);
+                    routes[stepStart(step) + i + down] = (spread(i, move + 1, moves) > down) ? 1.f : 0.f;
+                }
+            }
+        }
+    }
+
+    // How many times path i went down after `move` of `moves`, rounded to nearest
+    static constexpr int spread(int i, int move, int moves) {
+        return (2 * move * i + moves) / (2 * moves);
+    }
+
+    // The chance of going through each node, given the route knobs.
+    // One step at a time from the top: each node hands its chance down to its two children,
+    // split according to its route. Going left to right, what a node sends down is kept aside
+    // and added to what the next one sends up, since they share that child.
+    static void propagate(const float* routes, float* probabilities) {
+        probabilities[0] = 1.f;
+        for (int step = 1; step < STEPS; step++) {
+            int parent = stepStart(step - 1);
+            int child = stepStart(step);
+            float down = 0.f;
+            for (int i = 0; i < step; i++) {
+                probabilities[child + i] = down + probabilities[parent + i] * (1.f - routes[parent + i]);
+                down = probabilities[parent + i] * routes[parent + i];
+            }
+            probabilities[child + step] = down;
+        }
+    }
+
+    // What's downstream of the route knobs that moved: starting under the nodes from `first` to `last`
+    // on `step`, a wedge that gets one node wider every step. Anything outside it can't have changed.
+    struct Wedge {
+        int step = -1;
+        int first = 0;
+        int last = 0;
+
+        bool empty() const {
+            return step < 0;
+        }
+
+        void add(int node) {
+            int nodeStep = stepOf(node);
+            int position = node - stepStart(nodeStep);
+            if (empty()) {
+                step = nodeStep;
+                first = last = position;
+            } else if (nodeStep >= step) {
+                // Already inside if the wedge is wide enough by then
+                first = std::min(first, position);
+                last = std::max(last, position - (nodeStep - step));
+            } else {
+                // Start higher up, wide enough to still hold the old wedge
+                first = std::min(first, position);
+                last = std::max(position, last - (step - nodeStep));
+                step = nodeStep;
+            }
+        }
+    };
+
+    // Same as above, only reworking what's inside the wedge. The first node always stays at 100%.
+    static void propagate(const float* routes, float* probabilities, const Wedge& wedge) {
+        if (wedge.empty()) return;
+        int first = wedge.first;
+        int last = wedge.last;
+        for (int step = wedge.step + 1; step < STEPS; step++) {
+            last++;
+            int parent = stepStart(step - 1);
+            int child = stepStart(step);
+            for (int i = first; i <= last; i++) {
+                float down = (i > 0) ? probabilities[parent + i - 1] * routes[parent + i - 1] : 0.f;
+                float up = (i < step) ? probabilities[parent + i] * (1.f - routes[parent + i]) : 0.f;
+                probabilities[child + i] = down + up;
+            }
+        }
+    }
+};
+
+
+// The draws a seed leads to, kept around so that stepping is an array read.
+// A path is a pure function of its seed and the route knobs: the draws are worked out once per seed,
+// and the knobs are read when stepping, so moving one mid-path still counts right away.
+// Same results as seeding a fresh generator and drawing from it one step at a time.
+template <int STEPS, typename TPrng>
+struct Lookahead {
+    static const int COUNT = STEPS - 1;
+
+    float seed = NAN;
+    float draws[COUNT];
+    int computed = 0; // How many draws are cached
+    int position = 0; // How many draws the generator is past its seed
+    int used = 0; // How many draws this path used so far
+    TPrng prng;
+
+    // Starts over from the first draw, only seeding again for a new seed
+    void start(float seed) {
+        used = 0;
+        if (seed == this->seed) return;
+        this->seed = seed;
+        prng.init(seed, seed);
+        computed = 0;
+        position = 0;
+    }
+
+    // One of the first draws, working it out if it wasn't yet
+    float at(int i) {
+        while (computed <= i) {
+            draws[computed++] = prng.uniform();
+            position++;
+        }
+        return draws[i];
+    }
+
+    // The next draw of this path. Stepping back and forth can take more than there are steps,
+    // those aren't cached, but they're still the same as a fresh generator would give.
+    float next() {
+        if (used < COUNT) return at(used++);
+        if (position != used) {
+            prng.init(seed, seed);
+            for (position = 0; position < used; position++) prng.uniform();
+        }
+        position++;
+        used++;
+        return prng.uniform();
+    }
+
+    // The path this seed leads to, if every step follows the routes.
+    // With `reseeded`, every step starts over from the seed, so they all get the first draw.
+    void path(const float* routes, int* path, bool reseeded = false) {
+        path[0] = 0;
+        for (int step = 1; step < STEPS; step++) {
+            path[step] = Triangle<STEPS>::next(path[step - 1], step, routes[path[step - 1]], at(reseeded ? 0 : step - 1));
+        }
+    }
+};
+
+} // Routes
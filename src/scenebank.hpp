@@ -0,0 +1,255 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include "plugin.hpp"
+#include "quantizer.hpp"
+#include "chords.hpp"
+#include "javascript.hpp"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+// A library of chord progressions, parsed ahead of time into 16-scene banks that any
+// Qqqq, Quack or Q can swap in instantly, even from the audio thread.
+//
+// Progressions are imported from text files, one per line:
+//     # Comments start with a hash
+//     Axis: C G Am F
+//     Royal road @ C: IVmaj7 V7 iii7 vi
+// The part after @ is the key, which means the chords are Roman numerals.
+//
+// Or from JSON, which is also how the library is saved in the user folder:
+//     [{"name": "Axis", "leadSheet": "C G Am F"},
+//      {"name": "Royal road", "key": "C", "romanNumerals": "IVmaj7 V7 iii7 vi"},
+//      {"name": "Raw", "scenes": [[0, 4, 7], [2, 5, 9]]}]
+//
+// Importing a progression with the same name as one already in the library replaces it.
+namespace SceneBank {
+
+struct Bank {
+    std::string name;
+    // The name cut to fit the LCD, worked out at import so the audio thread can show it without allocating
+    char lcdName[12] = {};
+    std::array<Quantizer::ScaleMask, 16> scale;
+};
+
+// Positions can fall outside of the octave (Cb is -1, the 13th of B13 is 20), so they're wrapped
+// back into it. -60 is what the chord parser gives for notes it couldn't place, those are skipped.
+inline std::array<Quantizer::ScaleMask, 16> scalesFromProgression(const Chords::Progression& progression) {
+    std::array<Quantizer::ScaleMask, 16> scale;
+    for (size_t i = 0; i < progression.size() and i < 16; i++) {
+        for (int note : progression[i]) {
+            if (note != -60) scale[i].set(((note % 12) + 12) % 12);
+        }
+    }
+    return scale;
+}
+
+
+struct Library {
+    std::vector<Bank> banks;
+    // Position in banks, by name
+    std::map<std::string, size_t> index;
+
+    void add(Bank bank) {
+        std::strncpy(bank.lcdName, bank.name.c_str(), 11);
+        bank.lcdName[11] = '\0';
+        std::map<std::string, size_t>::iterator found = index.find(bank.name);
+        if (found != index.end()) {
+            banks[found->second] = bank;
+        } else {
+            index[bank.name] = banks.size();
+            banks.push_back(bank);
+        }
+    }
+
+    const Bank* find(const std::string& name) const {
+        std::map<std::string, size_t>::const_iterator found = index.find(name);
+        return (found == index.end()) ? NULL : &banks[found->second];
+    }
+
+    // "Name: chords" or "Name @ key: Roman numerals". False if the line isn't a progression.
+    bool addLine(const std::string& line) {
+        std::string trimmed = string::trim(line);
+        if (trimmed.empty() or trimmed[0] == '#') return false;
+        size_t colon = trimmed.find(':');
+        if (colon == std::string::npos) return false;
+        Bank bank;
+        bank.name = string::trim(trimmed.substr(0, colon));
+        std::string chords = string::trim(trimmed.substr(colon + 1));
+        size_t at = bank.name.rfind('@');
+        if (at != std::string::npos) {
+            std::string key = string::trim(bank.name.substr(at + 1));
+            bank.name = string::trim(bank.name.substr(0, at));
+            bank.scale = scalesFromProgression(Chords::romanNumerals(key, chords));
+        } else {
+            bank.scale = scalesFromProgression(Chords::leadSheet(chords));
+        }
+        if (bank.name.empty()) return false;
+        add(bank);
+        return true;
+    }
+
+    // Goes through the file a line at a time, so size doesn't matter. Returns how many were added.
+    int addTextFile(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        int added = 0;
+        while (std::getline(file, line)) {
+            if (addLine(line)) added++;
+        }
+        return added;
+    }
+
+    // Returns how many were added
+    int addJson(json_t* rootJ) {
+        int added = 0;
+        for (size_t i = 0; i < json_array_size(rootJ); i++) {
+            json_t* bankJ = json_array_get(rootJ, i);
+            json_t* nameJ = json_object_get(bankJ, "name");
+            if (! json_is_string(nameJ)) continue;
+            Bank bank;
+            bank.name = json_string_value(nameJ);
+            json_t* leadSheetJ = json_object_get(bankJ, "leadSheet");
+            json_t* romanNumeralsJ = json_object_get(bankJ, "romanNumerals");
+            json_t* keyJ = json_object_get(bankJ, "key");
+            json_t* scenesJ = json_object_get(bankJ, "scenes");
+            if (json_is_string(leadSheetJ)) {
+                bank.scale = scalesFromProgression(Chords::leadSheet(json_string_value(leadSheetJ)));
+            } else if (json_is_string(romanNumeralsJ)) {
+                std::string key = json_is_string(keyJ) ? json_string_value(keyJ) : "C";
+                bank.scale = scalesFromProgression(Chords::romanNumerals(key, json_string_value(romanNumeralsJ)));
+            } else if (json_is_array(scenesJ)) {
+                Chords::Progression progression(json_array_size(scenesJ));
+                for (size_t j = 0; j < progression.size(); j++) {
+                    json_t* sceneJ = json_array_get(scenesJ, j);
+                    for (size_t k = 0; k < json_array_size(sceneJ); k++) {
+                        progression[j].push_back(json_integer_value(json_array_get(sceneJ, k)));
+                    }
+                }
+                bank.scale = scalesFromProgression(progression);
+            } else {
+                continue;
+            }
+            add(bank);
+            added++;
+        }
+        return added;
+    }
+
+    json_t* toJson() const {
+        json_t* rootJ = json_array();
+        for (const Bank& bank : banks) {
+            json_t* bankJ = json_object();
+            json_object_set_new(bankJ, "name", json_string(bank.name.c_str()));
+            json_t* scenesJ = json_array();
+            for (int i = 0; i < 16; i++) {
+                json_t* sceneJ = json_array();
+                for (int j = 0; j < 12; j++) {
+                    if (bank.scale[i][j]) json_array_append_new(sceneJ, json_integer(j));
+                }
+                json_array_append_new(scenesJ, sceneJ);
+            }
+            json_object_set_new(bankJ, "scenes", scenesJ);
+            json_array_append_new(rootJ, bankJ);
+        }
+        return rootJ;
+    }
+};
+
+
+// The library shared by every instance.
+//
+// A library is never modified once published: an import builds a new one and swaps the pointer,
+// so the audio thread can read the current one without ever locking.
+// Imports run one at a time on the Javascript pool's thread. Only the previous library is kept
+// around, for whoever picked it up right before the swap: nobody holds on to one for longer than
+// a process() call or building a menu, which is over long before the next import can retire it.
+struct Store {
+    // Only touched from the pool's thread, once constructed
+    std::unique_ptr<Library> latest;
+    std::unique_ptr<Library> previous;
+    std::atomic<const Library*> current {NULL};
+    // Imports in progress, for the menu
+    std::atomic<int> importing {0};
+
+    static std::string filename() {
+        return asset::user("AriaSalvatrice/Qqqq/library.json");
+    }
+
+    Store() {
+        Library* library = new Library();
+        json_error_t error;
+        json_t* rootJ = json_load_file(filename().c_str(), 0, &error);
+        if (rootJ) {
+            library->addJson(rootJ);
+            json_decref(rootJ);
+        }
+        latest.reset(library);
+        current.store(library, std::memory_order_release);
+    }
+
+    // Never NULL. Safe from any thread.
+    const Library* get() {
+        return current.load(std::memory_order_acquire);
+    }
+
+    void save(const Library& library) {
+        system::createDirectory(asset::user("AriaSalvatrice"));
+        system::createDirectory(asset::user("AriaSalvatrice/Qqqq"));
+        json_t* rootJ = library.toJson();
+        json_dump_file(rootJ, filename().c_str(), JSON_INDENT(2));
+        json_decref(rootJ);
+    }
+
+    // Pool's thread only. Files ending in .json are JSON, anything else is text.
+    void importFile(const std::string& path) {
+        Library* library = new Library(*get());
+        int added = 0;
+        if (string::filenameExtension(string::filename(path)) == "json") {
+            json_error_t error;
+            json_t* rootJ = json_load_file(path.c_str(), 0, &error);
+            if (rootJ) {
+                added = library->addJson(rootJ);
+                json_decref(rootJ);
+            }
+        } else {
+            added = library->addTextFile(path);
+        }
+        current.store(library, std::memory_order_release);
+        // The one before the previous goes
+        previous = std::move(latest);
+        latest.reset(library);
+        save(*library);
+        INFO("Qqqq: imported %d progressions from %s, %d in the library", added, path.c_str(), (int) library->banks.size());
+    }
+
+    void importFileInBackground(const std::string& path) {
+        importing++;
+        Javascript::pool().post([this, path]() {
+            importFile(path);
+            importing--;
+        });
+    }
+};
+
+// Never destroyed, on purpose, see Store
+inline Store& store() {
+    static Store* store = new Store();
+    return *store;
+}
+
+} // SceneBank
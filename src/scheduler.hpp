@@ -0,0 +1,94 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <atomic>
+
+// Control-rate work, staggered across samples.
+//
+// With plain dsp::ClockDividers, every instance loaded together counts from 0 together,
+// so 20 Dariuses all refresh their LCD on the very same sample, and that sample blows the budget
+// at small buffer sizes. Here each divider gets its own phase when it's created, so the work
+// is spread out over the period instead.
+//
+// Phases follow a van der Corput sequence (0, 1/2, 1/4, 3/4, 1/8...): however many dividers
+// exist, they are always about evenly spaced, and adding one never lands next to an existing one.
+namespace Scheduler {
+
+// Turn off to get the old behavior where everything fires together. Only for benchmarks.
+// Function statics so that every module shares the same one, this is header-only.
+inline bool& staggered() {
+    static bool staggered = true;
+    return staggered;
+}
+
+// Dividers created so far, for the whole plugin
+inline std::atomic<uint32_t>& dividerCount() {
+    static std::atomic<uint32_t> count {0};
+    return count;
+}
+
+// Bit-reversed slot number, as a fraction of 2^32
+inline uint32_t vanDerCorput(uint32_t slot) {
+    slot = ((slot >> 1) & 0x55555555) | ((slot & 0x55555555) << 1);
+    slot = ((slot >> 2) & 0x33333333) | ((slot & 0x33333333) << 2);
+    slot = ((slot >> 4) & 0x0f0f0f0f) | ((slot & 0x0f0f0f0f) << 4);
+    slot = ((slot >> 8) & 0x00ff00ff) | ((slot & 0x00ff00ff) << 8);
+    return (slot >> 16) | (slot << 16);
+}
+
+// The phase of a slot for a given division, from 0 to division - 1
+inline uint32_t phaseOf(uint32_t slot, uint32_t division) {
+    if (!staggered()) return 0;
+    return ((uint64_t) vanDerCorput(slot) * division) >> 32;
+}
+
+
+// Drop-in replacement for dsp::ClockDivider, with its own phase.
+// It still fires exactly once every `division` samples, only on a different sample than its neighbors.
+struct Divider {
+    uint32_t clock = 0;
+    uint32_t division = 1;
+    uint32_t slot = dividerCount()++;
+
+    void reset() {
+        clock = phaseOf(slot, division);
+    }
+
+    // Setting the same division again is harmless, some modules do that every sample.
+    void setDivision(uint32_t division) {
+        if (division == this->division) return;
+        this->division = division;
+        reset();
+    }
+
+    uint32_t getDivision() {
+        return division;
+    }
+
+    uint32_t getClock() {
+        return clock;
+    }
+
+    bool process() {
+        clock++;
+        if (clock >= division) {
+            clock = 0;
+            return true;
+        }
+        return false;
+    }
+};
+
+} // Scheduler
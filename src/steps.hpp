@@ -0,0 +1,62 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// How Solomon moves from node to node. Nothing here knows about the module, so it can be tested on its own.
+// The prng is a template parameter: anything with uniform() and pickBit() will do.
+// The nodes in use are 0 to total - 1, there's always at least one.
+namespace Steps {
+
+// Bits for the nodes in use
+inline uint32_t mask(size_t total) {
+    return (total >= 32) ? 0xffffffff : (1u << total) - 1;
+}
+
+// Step forward can warp around
+inline size_t forward(size_t node, size_t total) {
+    return (node >= total - 1) ? 0 : node + 1;
+}
+
+// Step back can warp around
+inline size_t back(size_t node, size_t total) {
+    return (node == 0) ? total - 1 : node - 1;
+}
+
+// One of the queued nodes, all equally likely. Only call it if something's queued, or we crash.
+template <typename TPrng>
+inline size_t dequeue(TPrng& prng, uint32_t queue) {
+    return prng.pickBit(queue);
+}
+
+// Teleport never brings back to the current node - unless we only have one, or are in Repeat mode.
+template <typename TPrng>
+inline size_t teleport(TPrng& prng, size_t node, size_t total, bool repeat) {
+    if (total <= 1) return 0;
+    uint32_t validNodes = mask(total);
+    if (! repeat) validNodes &= ~(1u << node);
+    return prng.pickBit(validNodes);
+}
+
+// Random walk can warp around. In Repeat mode, 1 chance out of 3 the current node repeats,
+// then it's a coin flip which direction we go.
+template <typename TPrng>
+inline size_t walk(TPrng& prng, size_t node, size_t total, bool repeat) {
+    if (repeat && prng.uniform() < 1.f / 3.f) return node;
+    return (prng.uniform() >= 0.5f) ? forward(node, total) : back(node, total);
+}
+
+} // Steps
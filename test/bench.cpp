@@ -0,0 +1,140 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "quantizer.hpp"
+#include "prng.hpp"
+#include "routes.hpp"
+
+// The pure DSP pieces on their own, no Rack needed. `make bench` runs them.
+// What whole modules cost is measured from the Test module, inside Rack.
+namespace Bench {
+
+// Blocks of draws, the way a module would take them at control rate, ns/draw
+template <typename TPrng>
+inline double timeFill() {
+    const int DRAWS = 16000000;
+    const int BLOCK = 256;
+    float block[BLOCK];
+    TPrng prng;
+    prng.seed(42);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < DRAWS / BLOCK; i++) {
+        prng.fill(block, BLOCK);
+        sink = block[i % BLOCK];
+    }
+    return nanosecondsSince(start) / DRAWS;
+}
+
+// ns/call
+inline void runDsp() {
+    const int CALLS = 1000000;
+    Quantizer::ScaleMask scale = Quantizer::validNotesInScaleKey(Quantizer::BEBOP_MINOR, 4);
+    Quantizer::Engine engine;
+    engine.setScale(scale);
+    float voltage[16], quantized[16];
+    for (int c = 0; c < 16; c++) voltage[c] = c * 0.37f - 3.f;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) sink = Quantizer::quantize(voltage[i & 15] + i * 1e-6f, scale);
+    INFO("Quantizer::quantize          %8.1f ns/call", nanosecondsSince(start) / CALLS);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) sink = Quantizer::quantize(voltage[i & 15] + i * 1e-6f, scale, 2);
+    INFO("Quantizer::quantize +2sd     %8.1f ns/call", nanosecondsSince(start) / CALLS);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) sink = engine.quantize(voltage[i & 15] + i * 1e-6f);
+    INFO("Engine::quantize             %8.1f ns/call", nanosecondsSince(start) / CALLS);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS / 16; i++) {
+        voltage[i & 15] += 1e-6f;
+        engine.quantizeBlock(voltage, quantized, 16);
+        sink = quantized[i & 15];
+    }
+    INFO("Engine::quantizeBlock 16 ch  %8.1f ns/channel", nanosecondsSince(start) / CALLS);
+
+    // Before and after dropping the warm-ups
+    for (bool legacy : {true, false}) {
+        prng::prng prng;
+        prng.legacy = legacy;
+        prng.init(42.f, 69.f);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < CALLS; i++) sink = prng.uniform();
+        double ns = nanosecondsSince(start) / CALLS;
+        INFO("prng::uniform %-6s         %8.1f ns/call, %7.1f M draws/s", legacy ? "legacy" : "", ns, 1e3 / ns);
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < CALLS; i++) {
+            prng.init(i * 1e-6f, i * 1e-6f);
+            sink = prng.uniform();
+        }
+        ns = nanosecondsSince(start) / CALLS;
+        INFO("prng::init+uniform %-6s    %8.1f ns/call, %7.1f M seeds/s", legacy ? "legacy" : "", ns, 1e3 / ns);
+    }
+
+    double scalarNs = timeFill<prng::prng>();
+    double simd4Ns = timeFill<prng::prng4>();
+    double simd8Ns = timeFill<prng::prng8>();
+    INFO("prng::fill                   %8.2f ns/draw, %7.1f M draws/s", scalarNs, 1e3 / scalarNs);
+    INFO("prng4::fill                  %8.2f ns/draw, %7.1f M draws/s, %.1fx prng", simd4Ns, 1e3 / simd4Ns, scalarNs / simd4Ns);
+    INFO("prng8::fill                  %8.2f ns/draw, %7.1f M draws/s, %.1fx prng", simd8Ns, 1e3 / simd8Ns, scalarNs / simd8Ns);
+}
+
+// Working out Darius' probabilities from its route knobs, for each size of tree.
+// Also checks that every step still adds up to 100%.
+template <int STEPS>
+inline void runRoutes() {
+    typedef Routes::Triangle<STEPS> Triangle;
+    const int CALLS = 100000;
+    float routes[Triangle::NODES];
+    float probabilities[Triangle::NODES];
+    prng::prng knobs;
+    knobs.seed(STEPS);
+    for (int i = 0; i < Triangle::NODES; i++) routes[i] = knobs.uniform();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        routes[i % Triangle::NODES] = (i & 255) / 255.f;
+        Triangle::propagate(routes, probabilities);
+        sink = probabilities[Triangle::NODES - 1];
+    }
+    double ns = nanosecondsSince(start) / CALLS;
+
+    // One knob moving, the way Darius does it, should give the exact same thing as working it all out
+    float reference[Triangle::NODES];
+    int mismatches = 0;
+    double wedgeNs = 0.0;
+    for (int i = 0; i < CALLS; i++) {
+        int node = i % Triangle::stepStart(STEPS - 1);
+        routes[node] = (i & 255) / 255.f;
+        typename Triangle::Wedge changed;
+        changed.add(node);
+        start = std::chrono::steady_clock::now();
+        Triangle::propagate(routes, probabilities, changed);
+        wedgeNs += nanosecondsSince(start);
+        Triangle::propagate(routes, reference);
+        if (std::memcmp(probabilities, reference, sizeof(reference))) mismatches++;
+    }
+
+    double worst = 0.0;
+    for (int step = 0; step < STEPS; step++) {
+        double total = 0.0;
+        for (int i = Triangle::stepStart(step); i < Triangle::stepStart(step + 1); i++) total += probabilities[i];
+        worst = std::max(worst, std::fabs(total - 1.0));
+    }
+    INFO("Routes %2d steps %3d nodes  %8.1f ns/propagate, %8.1f ns for one knob, %d mismatches, worst step total off by %g",
+        STEPS, Triangle::NODES, ns, wedgeNs / CALLS, mismatches, worst);
+}
+
+void run() {
+    runDsp();
+    runRoutes<8>();
+    runRoutes<12>();
+    runRoutes<16>();
+}
+
+} // Bench
@@ -0,0 +1,169 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "chords.hpp"
+#include "javascript.hpp"
+#include "javascript-libraries.hpp"
+#include <random>
+#include <unistd.h>
+
+// Differential fuzzing of the native chord parser against the Tonal.js one it replaces.
+// Both should give the exact same JSON for every progression Qqqq can send them.
+// Needs QuickJS, skip it with `make test CHORD_FUZZ=0` on a box that can't fetch it.
+namespace ChordFuzz {
+
+const std::vector<std::string> LIBRARIES = {
+    JavascriptLibraries::TONALJS,
+    JavascriptLibraries::TOKENIZE,
+    JavascriptLibraries::TOSCALEPOSITION,
+    JavascriptLibraries::PARSEASLEADSHEET,
+    JavascriptLibraries::LEADSHEETTOQQQQ,
+    JavascriptLibraries::ROMANTOQQQQ
+};
+
+// Anything but quotes and backslashes, which break the Javascript string literal
+const std::vector<std::string> JUNK = {"a", "b", "c", "g", "A", "C", "G", "#", "x", "0", "4", "5", "7", "9", "1", "/", "(", ")",
+    "m", "M", "Δ", "ø", "o", "°", "+", "sus", "add", "aug", "dim", ",", "-", " ", "\xc2\xa0", "!", "?", ".", "*", "I", "V", "i", "v"};
+const std::vector<std::string> LETTERS = {"A", "B", "C", "D", "E", "F", "G", "a", "b", "c", "d", "e", "f", "g", "H", "X"};
+const std::vector<std::string> ACCIDENTALS = {"", "", "", "#", "b", "##", "bb", "x", "bbb", "#b"};
+const std::vector<std::string> ROMAN_NUMERALS = {"I", "II", "III", "IV", "V", "VI", "VII", "i", "ii", "iii", "iv", "v", "vi", "vii", "Iv", "VIII"};
+const std::vector<std::string> SEPARATORS = {" ", " ", ", ", "-", " - ", ",,", "  "};
+const std::vector<std::string> TONICS = {"C ", "C#", "D ", "D#", "E ", "F ", "F#", "G ", "G#", "A ", "A#", "B "};
+
+struct Generator {
+    std::mt19937 engine {42};
+    std::vector<std::string> chordTypes;
+
+    Generator() {
+        for (int i = 0; i < Chords::NUM_CHORD_TYPES; i++) {
+            for (const std::string& alias : Chords::splitOnSpaces(Chords::CHORD_TYPES[i][2])) {
+                if (alias.find('/') == std::string::npos) chordTypes.push_back(alias);
+            }
+        }
+    }
+
+    bool chance(float p) {
+        return std::uniform_real_distribution<float>(0.f, 1.f)(engine) < p;
+    }
+
+    const std::string& pick(const std::vector<std::string>& list) {
+        return list[std::uniform_int_distribution<size_t>(0, list.size() - 1)(engine)];
+    }
+
+    std::string junk() {
+        std::string text;
+        int length = std::uniform_int_distribution<int>(1, 8)(engine);
+        for (int i = 0; i < length; i++) text += pick(JUNK);
+        return text;
+    }
+
+    // No octave: Qqqq only ever passes pitch classes, and Tonal.js reads octaves differently anyway
+    std::string note() {
+        return pick(LETTERS) + pick(ACCIDENTALS);
+    }
+
+    std::string chord() {
+        if (chance(0.05f)) return junk();
+        std::string text = (chance(0.9f) ? note() : "") + (chance(0.85f) ? pick(chordTypes) : "");
+        if (chance(0.25f)) text += "/" + note();
+        return text;
+    }
+
+    std::string romanNumeral() {
+        if (chance(0.05f)) return junk();
+        std::string text = pick(ACCIDENTALS) + pick(ROMAN_NUMERALS) + (chance(0.7f) ? pick(chordTypes) : "");
+        if (chance(0.1f)) text += "/" + pick(ROMAN_NUMERALS);
+        return text;
+    }
+
+    std::string progression(bool roman) {
+        std::string text;
+        int length = std::uniform_int_distribution<int>(1, 10)(engine);
+        for (int i = 0; i < length; i++) {
+            if (i > 0) text += pick(SEPARATORS);
+            text += roman ? romanNumeral() : chord();
+        }
+        if (chance(0.1f)) text = "(" + text + ")";
+        return string::trim(text);
+    }
+};
+
+// A damaged cache must be thrown away before QuickJS ever sees it
+inline int checkCache() {
+    int failures = 0;
+    const uint64_t KEY = 0x5eed;
+    std::vector<uint8_t> bytecode(1000);
+    for (size_t i = 0; i < bytecode.size(); i++) bytecode[i] = i * 7;
+    std::string filename = Javascript::Pool::cacheFilename(KEY);
+
+    Javascript::Pool::writeCache(KEY, bytecode);
+    failures += check(Javascript::Pool::readCache(KEY) == bytecode, "  bytecode cache reads back what was written");
+
+    // Cut short
+    Javascript::Pool::writeCache(KEY, bytecode);
+    truncate(filename.c_str(), sizeof(Javascript::CacheHeader) + 10);
+    failures += check(Javascript::Pool::readCache(KEY).empty() and ! std::ifstream(filename), "  truncated cache is rejected and deleted");
+
+    // One byte flipped
+    Javascript::Pool::writeCache(KEY, bytecode);
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(sizeof(Javascript::CacheHeader) + 10);
+        file.put(0x42);
+    }
+    failures += check(Javascript::Pool::readCache(KEY).empty() and ! std::ifstream(filename), "  corrupted cache is rejected and deleted");
+    return failures;
+}
+
+int run() {
+    int failures = checkCache();
+    const int PROGRESSIONS = 20000;
+    INFO("Chord fuzz: %d progressions", PROGRESSIONS);
+    Generator generator;
+    int mismatches = 0;
+    double nativeNs = 0.0;
+    double tonalJsNs = 0.0;
+
+    Javascript::pool().run(LIBRARIES, [&](Javascript::Runtime& js) {
+        INFO("  before, %s", js.memoryUsage().toString().c_str());
+        for (int i = 0; i < PROGRESSIONS; i++) {
+            bool roman = (i % 3 == 2);
+            std::string tonic = generator.pick(TONICS);
+            std::string text = generator.progression(roman);
+
+            auto start = std::chrono::steady_clock::now();
+            std::string native = Chords::toJson(roman ? Chords::romanNumerals(tonic, text) : Chords::leadSheet(text));
+            nativeNs += nanosecondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            js.evaluateString("results = undefined");
+            if (roman) {
+                js.evaluateString("results = romanToQqqq('" + tonic + "', '" + text + "')");
+            } else {
+                js.evaluateString("results = leadsheetToQqqq('" + text + "')");
+            }
+            std::string tonalJs = js.readVariableAsString("results");
+            tonalJsNs += nanosecondsSince(start);
+
+            if (native != tonalJs) {
+                mismatches++;
+                if (mismatches <= 20) {
+                    INFO("  mismatch %s\"%s\" native %s Tonal.js %s", roman ? tonic.c_str() : "", text.c_str(), native.c_str(), tonalJs.c_str());
+                }
+            }
+        }
+        // Should be about the same as before, anything left over is a leak
+        js.collectGarbage();
+        INFO("  after,  %s", js.memoryUsage().toString().c_str());
+    });
+
+    INFO("  native   %10.1f ns/progression", nativeNs / PROGRESSIONS);
+    INFO("  Tonal.js %10.1f ns/progression", tonalJsNs / PROGRESSIONS);
+    failures += check(mismatches == 0, string::f("  native vs Tonal.js, %d mismatches", mismatches).c_str());
+    return failures;
+}
+
+} // ChordFuzz
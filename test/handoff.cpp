@@ -0,0 +1,71 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "handoff.hpp"
+#include <atomic>
+#include <thread>
+
+// A producer hammering a Handoff::Slot while the consumer reads it as fast as it can.
+// Every value is filled with a single number, so a torn read shows up as a mix of two.
+namespace HandoffTest {
+
+struct Value {
+    uint64_t words[64];
+};
+
+int run() {
+    INFO("Handoff:");
+    const uint64_t RECEIVES = 200000;
+    Handoff::Slot<Value> slot;
+    std::atomic<bool> stop {false};
+    uint64_t published = 0;
+
+    // Both sides yield, or on a single core box one of them hogs it
+    std::thread producer([&]() {
+        while (!stop) {
+            published++;
+            Value& value = slot.writeBuffer();
+            for (uint64_t& word : value.words) word = published;
+            slot.publish();
+            std::this_thread::yield();
+        }
+    });
+
+    uint64_t torn = 0, backwards = 0, received = 0, last = 0;
+    auto receive = [&](Value* value) {
+        received++;
+        for (uint64_t word : value->words) {
+            if (word != value->words[0]) {
+                torn++;
+                break;
+            }
+        }
+        if (value->words[0] <= last) backwards++;
+        last = value->words[0];
+    };
+    while (received < RECEIVES) {
+        Value* value = slot.consume();
+        if (value) {
+            receive(value);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    producer.join();
+    // Whatever was published last must still be waiting
+    Value* value = slot.consume();
+    if (value) receive(value);
+
+    int failures = 0;
+    INFO("  %llu of %llu values received", (unsigned long long) received, (unsigned long long) published);
+    failures += check(torn == 0, "  no torn values");
+    failures += check(backwards == 0, "  never goes back to an older value");
+    failures += check(last == published, "  the last value always gets through");
+    return failures;
+}
+
+} // HandoffTest
@@ -0,0 +1,50 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include "rack.hpp"
+#include <chrono>
+
+using namespace rack;
+
+// What the headless tests and benchmarks share. Every test returns how many checks failed.
+
+// Keeps the compiler from optimizing away what we measure
+extern volatile float sink;
+
+inline double nanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Wilson-Hilferty: roughly how many standard deviations a chi-square statistic is from what's expected
+inline double chiSquareZ(double chiSquare, int degreesOfFreedom) {
+    double k = degreesOfFreedom;
+    return (std::cbrt(chiSquare / k) - (1.0 - 2.0 / (9.0 * k))) / std::sqrt(2.0 / (9.0 * k));
+}
+
+inline int check(bool pass, const char* what) {
+    INFO("%-60s %s", what, pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+namespace QuantizerTest { int run(); }
+namespace HandoffTest { int run(); }
+namespace ChordFuzz { int run(); }
+namespace RouteSimulator { int run(); }
+namespace LookaheadTest { int run(); }
+namespace PrngBattery { int run(); }
+namespace StepsTest { int run(); }
+namespace PortableSequenceTest { int run(); }
+
+namespace Bench { void run(); }
@@ -0,0 +1,135 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "prng.hpp"
+#include "routes.hpp"
+#include <random>
+
+// Darius' cached draws: they have to be exactly what seeding a fresh prng and drawing from it would give,
+// or old patches stop leading to the same routes.
+namespace LookaheadTest {
+
+const int STEPS = 8;
+typedef Routes::Triangle<STEPS> Triangle;
+typedef Routes::Lookahead<STEPS, prng::prng> Lookahead;
+
+const int ROUTES = 100000;
+
+// Seeds the way random::uniform() gives them, 24 bits
+inline float randomSeed(std::mt19937_64& engine) {
+    return (engine() >> 40) / 16777216.f;
+}
+
+// Starts over from the seed before every draw, like Darius when the seed CV seeds every step
+struct Reseeding {
+    prng::prng prng;
+    float seed;
+
+    float uniform() {
+        prng.init(seed, seed);
+        return prng.uniform();
+    }
+};
+
+// Plays Darius: the next route gets worked out ahead for the display, then the two caches swap when
+// it starts. Stepping back draws nothing, so going back and forth takes more draws than there are steps.
+// Every draw is compared against a fresh prng. Returns how many didn't match.
+inline int playRoutes(bool legacy, int& longest) {
+    std::mt19937_64 engine {legacy ? 7 : 6};
+    float routes[Triangle::NODES];
+    for (float& route : routes) route = randomSeed(engine);
+    int path[STEPS];
+
+    Lookahead lookahead, upcoming;
+    lookahead.prng.legacy = upcoming.prng.legacy = legacy;
+    prng::prng fresh;
+    fresh.legacy = legacy;
+
+    float seed = randomSeed(engine);
+    float upcomingSeed = randomSeed(engine);
+    int mismatches = 0;
+    longest = 0;
+    for (int i = 0; i < ROUTES; i++) {
+        // Sometimes the seed CV holds the same seed, sometimes it's the one worked out ahead
+        switch (engine() % 3) {
+            case 0: break;
+            case 1: seed = upcomingSeed; upcomingSeed = randomSeed(engine); break;
+            case 2: seed = randomSeed(engine); break;
+        }
+        upcoming.start(upcomingSeed);
+        upcoming.path(routes, path);
+        if (lookahead.seed != seed && upcoming.seed == seed) std::swap(lookahead, upcoming);
+        lookahead.start(seed);
+        fresh.init(seed, seed);
+
+        int step = 0;
+        int draws = 0;
+        while (step < STEPS - 1) {
+            uint64_t move = engine() % 8;
+            if (move < 3 and step > 0) {
+                step--;
+            } else if (move < 4) {
+                // The display working out this route while it's being walked
+                lookahead.path(routes, path);
+            } else {
+                step++;
+                draws++;
+                if (lookahead.next() != fresh.uniform()) mismatches++;
+            }
+        }
+        longest = std::max(longest, draws);
+    }
+    return mismatches;
+}
+
+// The path shown ahead against walking it for real, with random knobs, some of them dead ends
+inline int comparePaths(bool legacy, bool reseeded) {
+    std::mt19937_64 engine {reseeded ? 9 : 8};
+    float routes[Triangle::NODES];
+    int cached[STEPS];
+    int walked[STEPS];
+    Lookahead lookahead;
+    lookahead.prng.legacy = legacy;
+    prng::prng fresh;
+    fresh.legacy = legacy;
+    Reseeding reseeding;
+    reseeding.prng.legacy = legacy;
+
+    int mismatches = 0;
+    for (int i = 0; i < ROUTES; i++) {
+        if (i % 100 == 0) {
+            for (float& route : routes) route = (engine() % 4 == 0) ? (float) (engine() % 2) : randomSeed(engine);
+        }
+        float seed = randomSeed(engine);
+        lookahead.start(seed);
+        lookahead.path(routes, cached, reseeded);
+        if (reseeded) {
+            reseeding.seed = seed;
+            Triangle::walk(routes, reseeding, walked);
+        } else {
+            fresh.init(seed, seed);
+            Triangle::walk(routes, fresh, walked);
+        }
+        if (!std::equal(cached, cached + STEPS, walked)) mismatches++;
+    }
+    return mismatches;
+}
+
+int run() {
+    INFO("Lookahead: %d routes each", ROUTES);
+    int failures = 0;
+    for (bool legacy : {false, true}) {
+        int longest;
+        int mismatches = playRoutes(legacy, longest);
+        INFO("  %s: %d draws that don't match, %d draws in the longest route", legacy ? "legacy" : "current", mismatches, longest);
+        failures += check(mismatches == 0 and longest > 2 * Lookahead::COUNT, legacy ? "next() same as a fresh prng, legacy" : "next() same as a fresh prng");
+        failures += check(comparePaths(legacy, false) == 0, legacy ? "path() same as walk, legacy" : "path() same as walk");
+        failures += check(comparePaths(legacy, true) == 0, legacy ? "path() reseeded same as walk, legacy" : "path() reseeded same as walk");
+    }
+    return failures;
+}
+
+} // LookaheadTest
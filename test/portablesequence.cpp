@@ -0,0 +1,64 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "portablesequence.hpp"
+
+// Copying a Portable Sequence and pasting it back should give the exact same notes,
+// and clamping should bring anything a sloppy sequencer sends back within range.
+namespace PortableSequenceTest {
+
+inline PortableSequence::Note note(float start, float pitch, float length, float velocity = -1.f, float playProbability = -1.f) {
+    PortableSequence::Note note;
+    note.start = start;
+    note.pitch = pitch;
+    note.length = length;
+    note.velocity = velocity;
+    note.playProbability = playProbability;
+    return note;
+}
+
+inline bool same(const PortableSequence::Note& a, const PortableSequence::Note& b) {
+    return a.start == b.start and a.pitch == b.pitch and a.length == b.length and a.velocity == b.velocity and a.playProbability == b.playProbability;
+}
+
+int run() {
+    INFO("Portable Sequence:");
+    int failures = 0;
+
+    // Floats that don't have a short decimal form, and the optional fields both present and missing
+    PortableSequence::Sequence sequence;
+    sequence.length = 7.f / 3.f;
+    sequence.addNote(note(0.f, 1.f / 12.f, 0.25f));
+    sequence.addNote(note(1.f / 3.f, -2.f / 7.f, 1.f, 8.5f));
+    sequence.addNote(note(2.f, 9.99f, 1e-6f, -1.f, 0.123456789f));
+    sequence.addNote(note(0.f, -10.f, 3.f, 0.f, 0.f));
+    sequence.toClipboard();
+
+    PortableSequence::Sequence pasted;
+    bool parsed = pasted.fromClipboard();
+    bool identical = parsed and pasted.length == sequence.length and pasted.notes.size() == sequence.notes.size();
+    for (size_t i = 0; identical and i < sequence.notes.size(); i++) identical = same(pasted.notes[i], sequence.notes[i]);
+    failures += check(identical, "  round trip through the clipboard, bit for bit");
+
+    PortableSequence::Sequence junk;
+    failures += check(! junk.fromJson("not json") and ! junk.fromJson("{\"notes\": []}")
+        and ! junk.fromJson("{\"vcvrack-sequence\": {\"length\": 4}}"), "  refuses what isn't a Portable Sequence");
+
+    PortableSequence::Sequence sloppy;
+    sloppy.addNote(note(-1.f, 12.f, -2.f, 11.f, 1.5f));
+    sloppy.addNote(note(3.f, -12.f, 1.f, -1.f, -1.f));
+    sloppy.clampValues();
+    failures += check(same(sloppy.notes[0], note(0.f, 10.f, 0.f, 10.f, 1.f)) and same(sloppy.notes[1], note(3.f, -10.f, 1.f)),
+        "  clamps to the legal range, leaves missing fields missing");
+
+    sequence.sort();
+    bool sorted = true;
+    for (size_t i = 1; i < sequence.notes.size(); i++) sorted = sorted and sequence.notes[i - 1].start <= sequence.notes[i].start;
+    failures += check(sorted, "  sorts by start");
+    return failures;
+}
+
+} // PortableSequenceTest
@@ -0,0 +1,141 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "prng.hpp"
+
+// A small battery on the prng output, the same kind of tests PractRand starts with, scaled down to run
+// in a few seconds. Every test gives a z score, beyond MAX_Z something's wrong.
+// Also checks that each SIMD lane gives the exact same draws as a plain prng jumped the same number of times.
+namespace PrngBattery {
+
+const uint64_t DRAWS = 1 << 26;
+const int BLOCK = 4096;
+const int SEEDS = 1 << 22;
+const double MAX_Z = 4.0;
+
+// Everything here looks at draws as 24 bit integers
+inline uint32_t bitsOf(float draw) {
+    return draw * 16777216.f;
+}
+
+// Expected to be flat, so the chi-square is against the average
+inline double flatZ(const std::vector<uint64_t>& counts) {
+    uint64_t total = 0;
+    for (uint64_t count : counts) total += count;
+    double expected = (double) total / counts.size();
+    double chiSquare = 0.0;
+    for (uint64_t count : counts) chiSquare += (count - expected) * (count - expected) / expected;
+    return chiSquareZ(chiSquare, counts.size() - 1);
+}
+
+struct Battery {
+    int lanes;
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(4096, 0); // Top 12 bits
+    std::vector<uint64_t> ones = std::vector<uint64_t>(24, 0); // Each bit on its own
+    std::vector<uint64_t> serial = std::vector<uint64_t>(64 * 64, 0); // Two draws in a row from the same lane
+    std::vector<uint64_t> crossLane = std::vector<uint64_t>(64 * 64, 0); // The same draw from two neighbor lanes
+    uint64_t draws = 0;
+    uint32_t previous[8];
+    bool havePrevious[8] = {};
+
+    Battery(int lanes) : lanes(lanes) {}
+
+    void add(const float* block, int count) {
+        for (int i = 0; i < count; i++) {
+            uint32_t draw = bitsOf(block[i]);
+            buckets[draw >> 12]++;
+            for (int bit = 0; bit < 24; bit++) ones[bit] += (draw >> bit) & 1;
+
+            // Pairs don't overlap, so the cells are independent
+            int lane = i % lanes;
+            if (havePrevious[lane]) serial[(previous[lane] >> 18) * 64 + (draw >> 18)]++;
+            previous[lane] = draw;
+            havePrevious[lane] = !havePrevious[lane];
+
+            if (lane % 2 == 1) crossLane[(bitsOf(block[i - 1]) >> 18) * 64 + (draw >> 18)]++;
+        }
+        draws += count;
+    }
+
+    double bitsZ() const {
+        double chiSquare = 0.0;
+        for (uint64_t count : ones) chiSquare += (count - draws / 2.0) * (count - draws / 2.0) / (draws / 4.0);
+        return chiSquareZ(chiSquare, ones.size());
+    }
+};
+
+inline bool report(const char* name, const char* test, double z) {
+    bool pass = std::fabs(z) <= MAX_Z;
+    INFO("  %-8s %-28s z %6.2f %s", name, test, z, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+// Returns how many tests failed
+template <typename TPrng>
+inline int runBattery(const char* name, int lanes) {
+    int failures = 0;
+
+    // Lane by lane against the scalar version
+    if (lanes > 1) {
+        std::vector<prng::prng> reference(lanes);
+        reference[0].seed(42);
+        for (int lane = 1; lane < lanes; lane++) {
+            reference[lane] = reference[lane - 1];
+            reference[lane].jump();
+        }
+        TPrng prng;
+        prng.seed(42);
+        std::vector<float> block(BLOCK);
+        int mismatches = 0;
+        for (int i = 0; i < 16; i++) {
+            prng.fill(block.data(), BLOCK);
+            for (int j = 0; j < BLOCK; j++) {
+                if (block[j] != reference[j % lanes].uniform()) mismatches++;
+            }
+        }
+        INFO("  %-8s %-28s %d mismatches %s", name, "lanes vs scalar", mismatches, mismatches ? "FAIL" : "PASS");
+        if (mismatches) failures++;
+    }
+
+    // One long stream
+    Battery battery {lanes};
+    TPrng prng;
+    prng.seed(1234);
+    std::vector<float> block(BLOCK);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < DRAWS; i += BLOCK) {
+        prng.fill(block.data(), BLOCK);
+        battery.add(block.data(), BLOCK);
+    }
+    double seconds = nanosecondsSince(start) / 1e9;
+    if (!report(name, "top 12 bits", flatZ(battery.buckets))) failures++;
+    if (!report(name, "each bit", battery.bitsZ())) failures++;
+    if (!report(name, "pairs in a lane", flatZ(battery.serial))) failures++;
+    if (lanes > 1 and !report(name, "pairs across lanes", flatZ(battery.crossLane))) failures++;
+
+    // Seeds right next to each other, the way a slowly moving seed voltage gives them
+    std::vector<uint64_t> firstDraws(4096, 0);
+    for (int i = 0; i < SEEDS; i++) {
+        prng.init(i * 1e-6f, 0.f);
+        prng.fill(block.data(), lanes);
+        firstDraws[bitsOf(block[0]) >> 12]++;
+    }
+    if (!report(name, "first draw of nearby seeds", flatZ(firstDraws))) failures++;
+
+    INFO("  %-8s %llu draws in %.2f s", name, (unsigned long long) DRAWS, seconds);
+    return failures;
+}
+
+int run() {
+    INFO("Prng battery:");
+    int failures = 0;
+    failures += runBattery<prng::prng>("prng", 1);
+    failures += runBattery<prng::prng4>("prng4", 4);
+    failures += runBattery<prng::prng8>("prng8", 8);
+    return failures;
+}
+
+} // PrngBattery
@@ -0,0 +1,95 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "quantizer.hpp"
+
+// Quantizer::Engine promises the same results as Quantizer::quantize, bit for bit.
+// Checks that on every possible 12-bit scale, not just the ones in the menu.
+namespace QuantizerTest {
+
+inline bool same(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// Every quarter-tone boundary from -11V to 11V and the floats right next to it, where rounding bites,
+// plus a fine sweep in between
+inline std::vector<float> voltages(int stepsPerOctave) {
+    std::vector<float> voltages;
+    for (int i = -11 * 24; i <= 11 * 24; i++) {
+        float boundary = i / 24.f;
+        voltages.push_back(boundary);
+        voltages.push_back(std::nextafter(boundary, -INFINITY));
+        voltages.push_back(std::nextafter(boundary, INFINITY));
+        voltages.push_back(boundary - Quantizer::FUDGEOFFSET);
+    }
+    for (int i = -11 * stepsPerOctave; i <= 11 * stepsPerOctave; i++) voltages.push_back((float) i / stepsPerOctave + 0.0001f);
+    return voltages;
+}
+
+// Returns the number of mismatches, logs the first few
+inline int compare(const std::vector<float>& sweep, int minTransposeSd, int maxTransposeSd) {
+    int mismatches = 0;
+    Quantizer::Engine engine;
+    for (int bits = 0; bits < 4096; bits++) {
+        Quantizer::ScaleMask scale((uint16_t) bits);
+        engine.setScale(scale);
+        for (int transposeSd = minTransposeSd; transposeSd <= maxTransposeSd; transposeSd++) {
+            for (float voltage : sweep) {
+                float expected = Quantizer::quantize(voltage, scale, transposeSd);
+                float got = engine.quantize(voltage, transposeSd);
+                if (!same(expected, got)) {
+                    if (mismatches < 10) INFO("  scale %03x %+.9gV %+d sd: quantize %.9g, Engine %.9g", bits, voltage, transposeSd, expected, got);
+                    mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Four lanes and whole blocks against the scalar Engine, which is checked against the reference above
+inline int compareSimd(const std::vector<float>& sweep) {
+    int mismatches = 0;
+    Quantizer::Engine engine;
+    for (int bits = 0; bits < 4096; bits += 7) {
+        engine.setScale(Quantizer::ScaleMask((uint16_t) bits));
+        for (int transposeSd : {0, 1, -3, 8}) {
+            for (size_t i = 0; i + 16 <= sweep.size(); i += 16) {
+                float in[16], out[16];
+                // Different voltages in each lane
+                for (int c = 0; c < 16; c++) in[c] = sweep[(i + c * 37) % sweep.size()];
+                int channels = 1 + (i / 16) % 16;
+                engine.quantizeBlock(in, out, channels, transposeSd);
+                for (int c = 0; c < channels; c++) {
+                    if (!same(out[c], engine.quantize(in[c], transposeSd))) mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+int run() {
+    INFO("Quantizer:");
+    int failures = 0;
+    std::vector<float> fine = voltages(240);
+    std::vector<float> coarse = voltages(24);
+
+    int mismatches = compare(fine, 0, 0);
+    failures += check(mismatches == 0, string::f("  Engine vs quantize, 4096 scales, %d voltages", (int) fine.size()).c_str());
+    mismatches = compare(coarse, -8, 8);
+    failures += check(mismatches == 0, "  Engine vs quantize, transposed -8 to +8 scale degrees");
+    mismatches = compareSimd(fine);
+    failures += check(mismatches == 0, "  float_4 and quantizeBlock vs scalar Engine");
+
+    // No valid notes passes the voltage through, clamped
+    Quantizer::Engine engine;
+    engine.setScale(Quantizer::ScaleMask());
+    failures += check(engine.quantize(12.f) == 10.f and same(engine.quantize(1.2f), 1.2f + Quantizer::FUDGEOFFSET), "  empty scale passes through");
+    return failures;
+}
+
+} // QuantizerTest
@@ -0,0 +1,139 @@
+/*             DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+                    Version 2, December 2004
+
+ Copyright (C) 2004 Sam Hocevar <sam@hocevar.net>
+
+ Everyone is permitted to copy and distribute verbatim or modified
+ copies of this license document, and changing it is allowed as long
+ as the name is changed.
+
+            DO WHAT THE FUCK YOU WANT TO PUBLIC LICENSE
+   TERMS AND CONDITIONS FOR COPYING, DISTRIBUTION AND MODIFICATION
+
+  0. You just DO WHAT THE FUCK YOU WANT TO.
+*/
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <emmintrin.h>
+#include <jansson.h>
+#include <sys/stat.h>
+
+// Just enough of Rack for the header-only parts of the plugin to build without the SDK.
+// Only what those headers actually use, doing the same thing Rack does.
+#define INFO(format, ...) std::printf(format "\n", ##__VA_ARGS__)
+#define WARN(format, ...) std::printf("warning: " format "\n", ##__VA_ARGS__)
+
+// The clipboard is a string in memory, so copying and pasting Portable Sequences can be tested
+struct GLFWwindow;
+
+inline std::string& clipboard() {
+    static std::string clipboard;
+    return clipboard;
+}
+
+inline void glfwSetClipboardString(GLFWwindow* window, const char* string) {
+    clipboard() = string;
+}
+
+inline const char* glfwGetClipboardString(GLFWwindow* window) {
+    return clipboard().c_str();
+}
+
+namespace rack {
+
+namespace math {
+inline float clamp(float x, float a, float b) { return std::fmax(std::fmin(x, b), a); }
+inline int clamp(int x, int a, int b) { return std::max(std::min(x, b), a); }
+}
+using namespace math;
+
+namespace simd {
+// Only float_4, and only the operations the quantizer and the prng need
+struct float_4 {
+    union { __m128 v; float s[4]; };
+    float_4() {}
+    float_4(__m128 v) : v(v) {}
+    float_4(float x) : v(_mm_set1_ps(x)) {}
+    static float_4 load(const float* x) { return _mm_loadu_ps(x); }
+    void store(float* x) { _mm_storeu_ps(x, v); }
+    float& operator[](int i) { return s[i]; }
+    const float& operator[](int i) const { return s[i]; }
+};
+inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+inline float_4& operator+=(float_4& a, float_4 b) { return a = a + b; }
+inline float_4 operator>=(float_4 a, float_4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline float_4 floor(float_4 a) {
+    return float_4(_mm_setr_ps(std::floor(a[0]), std::floor(a[1]), std::floor(a[2]), std::floor(a[3])));
+}
+inline float_4 clamp(float_4 x, float_4 a, float_4 b) { return _mm_min_ps(_mm_max_ps(x.v, a.v), b.v); }
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+}
+
+namespace string {
+inline std::string f(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    char buffer[4096];
+    std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return buffer;
+}
+
+inline std::string trim(const std::string& s) {
+    const std::string whitespace = " \n\r\t";
+    size_t first = s.find_first_not_of(whitespace);
+    if (first == std::string::npos) return "";
+    size_t last = s.find_last_not_of(whitespace);
+    return s.substr(first, last - first + 1);
+}
+}
+
+namespace random {
+inline uint64_t u64() {
+    static std::mt19937_64 engine {std::random_device()()};
+    return engine();
+}
+}
+
+// The user folder is the build folder, so nothing leaks into a real Rack install
+namespace asset {
+inline std::string user(const std::string& filename) {
+    return "build/user/" + filename;
+}
+}
+
+namespace system {
+inline void createDirectory(const std::string& path) {
+    mkdir("build/user", 0755);
+    mkdir(path.c_str(), 0755);
+}
+}
+
+struct Window {
+    GLFWwindow* win = NULL;
+};
+
+struct Context {
+    Window* window;
+};
+
+inline Context* contextGet() {
+    static Window window;
+    static Context context {&window};
+    return &context;
+}
+
+#define APP rack::contextGet()
+
+} // rack
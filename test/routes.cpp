@@ -0,0 +1,163 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "prng.hpp"
+#include "routes.hpp"
+#include <random>
+#include <thread>
+
+// Monte Carlo of Darius' routing: walks millions of paths with the same code and prng as the module,
+// and checks how often each node gets visited against the probabilities updateRoutes works out.
+// Run it after touching the route math or the prng. Also says how many paths per second that costs.
+namespace RouteSimulator {
+
+const int STEPS = 8;
+typedef Routes::Triangle<STEPS> Triangle;
+
+// Beyond this many standard deviations, something's wrong
+const double MAX_Z = 4.0;
+
+struct Preset {
+    std::string name;
+    std::vector<float> routes;
+};
+
+// The same knob settings as the Darius menu, and a few random ones, some with dead ends
+inline std::vector<Preset> presets() {
+    std::vector<Preset> presets;
+    std::mt19937 engine {42};
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+    Preset center {"Center", std::vector<float>(Triangle::NODES, 0.5f)};
+    presets.push_back(center);
+
+    Preset spread {"Spread out", std::vector<float>(Triangle::NODES, 0.5f)};
+    for (int step = 0; step < STEPS - 1; step++) {
+        for (int i = 0; i <= step; i++) spread.routes[Triangle::stepStart(step) + i] = (i + 1) / (step + 2.f);
+    }
+    presets.push_back(spread);
+
+    Preset binaryTree {"Binary tree", std::vector<float>(Triangle::NODES)};
+    Triangle::binaryTree(binaryTree.routes.data());
+    presets.push_back(binaryTree);
+
+    Preset randomized {"Random", std::vector<float>(Triangle::NODES)};
+    for (float& route : randomized.routes) route = uniform(engine);
+    presets.push_back(randomized);
+
+    Preset deadEnds {"Dead ends", std::vector<float>(Triangle::NODES)};
+    for (float& route : deadEnds.routes) route = (uniform(engine) < 0.3f) ? std::round(uniform(engine)) : uniform(engine);
+    presets.push_back(deadEnds);
+
+    return presets;
+}
+
+// The binary tree used to be written out by hand for 8 steps, this is what it was.
+// A 16-step tree starts the same, and splits right before its last step, so every node there is as likely.
+inline int checkBinaryTree() {
+    float routes[Triangle::NODES];
+    Triangle::binaryTree(routes);
+    std::vector<float> expected(Triangle::NODES, 0.5f);
+    for (int node : {1, 6, 7, 10, 13, 15, 17}) expected[node] = 0.f;
+    for (int node : {2, 8, 9, 11, 14, 18, 20}) expected[node] = 1.f;
+    int failures = check(std::equal(expected.begin(), expected.end(), routes), "binary tree, same as the 8-step one by hand");
+
+    typedef Routes::Triangle<16> BigTriangle;
+    float bigRoutes[BigTriangle::NODES];
+    float probabilities[BigTriangle::NODES];
+    BigTriangle::binaryTree(bigRoutes);
+    BigTriangle::propagate(bigRoutes, probabilities);
+    bool even = true;
+    for (int i = BigTriangle::stepStart(15); i < BigTriangle::NODES; i++) even = even and probabilities[i] == 1.f / 16.f;
+    failures += check(even and std::equal(routes, routes + Triangle::NODES - STEPS, bigRoutes), "binary tree on 16 steps, starts the same and ends even");
+    return failures;
+}
+
+// Walks paths on one thread and counts the visits. Darius seeds its prng again at the start of
+// every path, so `reseed` does the same, from 24 bit seeds like random::uniform() gives.
+// Otherwise it's one long stream from a single seed, which tests the routing without the seeds colliding.
+// `legacy` seeds and draws the way old Darius patches still do.
+inline void simulate(const float* routes, uint64_t seed, bool reseed, bool legacy, uint64_t paths, uint64_t* visits) {
+    std::mt19937_64 seeds {seed};
+    prng::prng prng;
+    prng.legacy = legacy;
+    prng.init(seed, seed);
+    int path[STEPS];
+    for (uint64_t i = 0; i < paths; i++) {
+        if (reseed) {
+            float pathSeed = (seeds() >> 40) / 16777216.f;
+            prng.init(pathSeed, pathSeed);
+        }
+        Triangle::walk(routes, prng, path);
+        for (int step = 0; step < STEPS; step++) visits[path[step]]++;
+    }
+}
+
+// Returns false if the visits don't match
+inline bool simulatePreset(const Preset& preset, bool reseed, bool legacy, uint64_t paths, unsigned threads) {
+    std::vector<std::vector<uint64_t>> visits(threads, std::vector<uint64_t>(Triangle::NODES, 0));
+    std::vector<std::thread> workers;
+    uint64_t pathsPerThread = paths / threads;
+    paths = pathsPerThread * threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(std::thread(simulate, preset.routes.data(), 1000 + t, reseed, legacy, pathsPerThread, visits[t].data()));
+    }
+    for (std::thread& worker : workers) worker.join();
+    double seconds = nanosecondsSince(start) / 1e9;
+
+    std::vector<uint64_t> total(Triangle::NODES, 0);
+    for (unsigned t = 0; t < threads; t++) {
+        for (int i = 0; i < Triangle::NODES; i++) total[i] += visits[t][i];
+    }
+    float probabilities[Triangle::NODES];
+    Triangle::propagate(preset.routes.data(), probabilities);
+
+    // Each step on its own, since a path visits one node per step
+    bool pass = true;
+    double worstZ = 0.0;
+    for (int step = 1; step < STEPS; step++) {
+        double chiSquare = 0.0;
+        int reachable = 0;
+        for (int i = Triangle::stepStart(step); i < Triangle::stepStart(step + 1); i++) {
+            double expected = paths * (double) probabilities[i];
+            if (expected > 0.0) {
+                chiSquare += (total[i] - expected) * (total[i] - expected) / expected;
+                reachable++;
+            } else if (total[i] > 0) {
+                INFO("  %s visited node %d %llu times, it should be impossible", preset.name.c_str(), i, (unsigned long long) total[i]);
+                pass = false;
+            }
+        }
+        if (reachable < 2) continue;
+        double z = chiSquareZ(chiSquare, reachable - 1);
+        if (std::fabs(z) > std::fabs(worstZ)) worstZ = z;
+        if (std::fabs(z) > MAX_Z) {
+            INFO("  %s step %d chi-square %.2f with %d degrees of freedom, z %.2f", preset.name.c_str(), step + 1, chiSquare, reachable - 1, z);
+            pass = false;
+        }
+    }
+
+    INFO("  %-10s %-8s %-6s %10llu paths %6.2f M paths/s, worst step z %5.2f %s", preset.name.c_str(), reseed ? "reseeded" : "stream", legacy ? "legacy" : "",
+        (unsigned long long) paths, paths / seconds / 1e6, worstZ, pass ? "PASS" : "FAIL");
+    return pass;
+}
+
+int run() {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    INFO("Route simulator: %u threads", threads);
+    int failures = checkBinaryTree();
+    for (const Preset& preset : presets()) {
+        if (!simulatePreset(preset, false, false, 1 << 24, threads)) failures++;
+        // Fewer paths, or the 24 bit seeds start repeating often enough to skew the statistics
+        if (!simulatePreset(preset, true, false, 1 << 20, threads)) failures++;
+        if (!simulatePreset(preset, true, true, 1 << 20, threads)) failures++;
+    }
+    return failures;
+}
+
+} // RouteSimulator
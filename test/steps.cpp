@@ -0,0 +1,100 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+#include "prng.hpp"
+#include "steps.hpp"
+
+// Solomon's moves: where each one may land, and that the random ones are fair about it.
+namespace StepsTest {
+
+const int DRAWS = 1 << 20;
+// Beyond this many standard deviations, something's wrong
+const double MAX_Z = 4.0;
+
+// Chi-square z of counts against the expected share of each, 0 for the ones that must never happen
+inline double z(const std::vector<uint64_t>& counts, const std::vector<double>& shares) {
+    double chiSquare = 0.0;
+    int cells = 0;
+    uint64_t total = 0;
+    for (uint64_t count : counts) total += count;
+    for (size_t i = 0; i < counts.size(); i++) {
+        if (shares[i] == 0.0) continue;
+        double expected = total * shares[i];
+        chiSquare += (counts[i] - expected) * (counts[i] - expected) / expected;
+        cells++;
+    }
+    return (cells < 2) ? 0.0 : chiSquareZ(chiSquare, cells - 1);
+}
+
+int run() {
+    INFO("Steps:");
+    int failures = 0;
+    prng::prng prng;
+    prng.seed(42);
+
+    bool wraps = true;
+    for (size_t total = 1; total <= 32; total++) {
+        for (size_t node = 0; node < total; node++) {
+            wraps = wraps and Steps::forward(node, total) < total and Steps::back(node, total) < total
+                and Steps::back(Steps::forward(node, total), total) == node;
+        }
+        wraps = wraps and Steps::forward(total - 1, total) == 0 and Steps::back(0, total) == total - 1;
+    }
+    failures += check(wraps, "  back and forward wrap around, 1 to 32 nodes");
+
+    // Teleports and walks from every node, counting where they land relative to it
+    double worstTeleport = 0.0, worstWalk = 0.0;
+    bool teleportInRange = true, walkInRange = true;
+    for (size_t total : {1, 2, 3, 4, 8, 16}) {
+        for (bool repeat : {false, true}) {
+            std::vector<uint64_t> teleports(total, 0);
+            std::vector<uint64_t> walks(3, 0); // Stayed, forward, back
+            for (int i = 0; i < DRAWS; i++) {
+                size_t node = i % total;
+                size_t to = Steps::teleport(prng, node, total, repeat);
+                if (to >= total or (! repeat and total > 1 and to == node)) teleportInRange = false;
+                else teleports[(to + total - node) % total]++;
+
+                to = Steps::walk(prng, node, total, repeat);
+                if (to == node and (repeat or total == 1)) walks[0]++;
+                else if (to == Steps::forward(node, total)) walks[1]++;
+                else if (to == Steps::back(node, total)) walks[2]++;
+                else walkInRange = false;
+            }
+            std::vector<double> teleportShares(total, 1.0 / (repeat ? total : std::max<size_t>(total - 1, 1)));
+            if (! repeat and total > 1) teleportShares[0] = 0.0;
+            worstTeleport = std::max(worstTeleport, std::fabs(z(teleports, teleportShares)));
+            // With 1 or 2 nodes forward and back land in the same place, the first of them counts it
+            if (total > 2) worstWalk = std::max(worstWalk, std::fabs(z(walks, repeat ? std::vector<double> {1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0} : std::vector<double> {0.0, 0.5, 0.5})));
+        }
+    }
+    failures += check(teleportInRange, "  teleport never stays put, unless Repeat or a single node");
+    failures += check(worstTeleport <= MAX_Z, string::f("  teleport is fair, worst z %.2f", worstTeleport).c_str());
+    failures += check(walkInRange, "  walk only goes to a neighbor, or stays in Repeat mode");
+    failures += check(worstWalk <= MAX_Z, string::f("  walk is fair, worst z %.2f", worstWalk).c_str());
+
+    // Every queued node equally likely, nothing else ever picked
+    bool queueInRange = true;
+    double worstQueue = 0.0;
+    for (uint32_t queue : {0x1u, 0x8001u, 0xa5u, 0xffffu, 0xffffffffu, 0x80000000u}) {
+        std::vector<uint64_t> picks(32, 0);
+        std::vector<double> shares(32, 0.0);
+        for (int bit = 0; bit < 32; bit++) {
+            if (queue & (1u << bit)) shares[bit] = 1.0 / __builtin_popcount(queue);
+        }
+        for (int i = 0; i < DRAWS; i++) {
+            size_t node = Steps::dequeue(prng, queue);
+            if (! (queue & (1u << node))) queueInRange = false;
+            picks[node]++;
+        }
+        worstQueue = std::max(worstQueue, std::fabs(z(picks, shares)));
+    }
+    failures += check(queueInRange, "  dequeue only picks queued nodes");
+    failures += check(worstQueue <= MAX_Z, string::f("  dequeue is fair, worst z %.2f", worstQueue).c_str());
+    return failures;
+}
+
+} // StepsTest
@@ -0,0 +1,32 @@
+/*  Copyright (C) 2019-2020 Aria Salvatrice
+This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 3.
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+You should have received a copy of the GNU General Public License along with this program. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "harness.hpp"
+
+// `make test` runs everything, `make test ONLY=quantizer` just one of them.
+// Exits with the number of failures, so anything but 0 is bad news.
+
+volatile float sink = 0.f;
+
+int main(int argc, char** argv) {
+    if (argc > 1 and std::string(argv[1]) == "bench") {
+        Bench::run();
+        return 0;
+    }
+    std::string only = (argc > 1) ? argv[1] : "";
+    int failures = 0;
+    if (only.empty() or only == "quantizer") failures += QuantizerTest::run();
+    if (only.empty() or only == "handoff") failures += HandoffTest::run();
+    if (only.empty() or only == "routes") failures += RouteSimulator::run();
+    if (only.empty() or only == "lookahead") failures += LookaheadTest::run();
+    if (only.empty() or only == "prng") failures += PrngBattery::run();
+    if (only.empty() or only == "steps") failures += StepsTest::run();
+    if (only.empty() or only == "portablesequence") failures += PortableSequenceTest::run();
+#ifdef CHORD_FUZZ
+    if (only.empty() or only == "chords") failures += ChordFuzz::run();
+#endif
+    INFO("%d failures", failures);
+    return std::min(failures, 125);
+}